@@ -0,0 +1,476 @@
+#include <algorithm>
+#include <iostream>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "../benchmark.h"
+#include "biginteger.hpp"
+
+class Generator {
+ public:
+  explicit Generator(unsigned long long seed) : engine_(seed) {}
+
+  BigInteger number(size_t limbs, bool negative = false);
+
+  std::string digits(size_t limbs);
+
+  BigInteger bits(size_t bits);
+
+  unsigned long long below(unsigned long long bound) {
+    return engine_() % bound;
+  }
+
+  static BigInteger::Limb maxLimb() {
+    return sizeof(BigInteger::Limb) == 8 ? ~BigInteger::Limb{0}
+                                         : kDecimalLimb - 1;
+  }
+
+ private:
+  static const unsigned long long kDecimalLimb = 1000000000;
+  static const size_t kDigitsPerLimb = sizeof(BigInteger::Limb) == 8 ? 19 : 9;
+  std::mt19937_64 engine_;
+
+  BigInteger::Limb limb();
+};
+
+BigInteger::Limb Generator::limb() {
+  if constexpr (sizeof(BigInteger::Limb) == 8) {
+    return engine_();
+  } else {
+    return static_cast<BigInteger::Limb>(engine_() % kDecimalLimb);
+  }
+}
+
+BigInteger Generator::number(size_t limbs, bool negative) {
+  std::vector<BigInteger::Limb> digits(limbs);
+  for (auto& digit : digits) {
+    digit = limb();
+  }
+  while (digits.back() == 0) {
+    digits.back() = limb();
+  }
+  return BigIntegerView(digits.data(), digits.size(), negative)
+          .toBigInteger();
+}
+
+BigInteger Generator::bits(size_t bits) {
+  BigInteger top = BigInteger::pow(2, bits - 1);
+  return top + number(bits / 29 + 1) % top;
+}
+
+std::string Generator::digits(size_t limbs) {
+  std::string str(limbs * kDigitsPerLimb, '0');
+  for (auto& digit : str) {
+    digit = static_cast<char>('0' + engine_() % 10);
+  }
+  str[0] = static_cast<char>('1' + engine_() % 9);
+  return str;
+}
+
+void IntegerBenchmarks(BenchmarkSuite& suite) {
+  const size_t kLinearLimit = 1000000;
+  const size_t kQuadraticLimit = 10000;
+  size_t max_limbs = suite.limit("max-limbs");
+  for (size_t size : Sizes(1, std::min(kLinearLimit, max_limbs))) {
+    Generator generator(size);
+    BigInteger left = generator.number(size);
+    BigInteger right = generator.number(size, true);
+    if (suite.selected("add")) {
+      suite.run("add", size, [&]() { return (left + right).getArr().size(); });
+    }
+    if (suite.selected("sub")) {
+      suite.run("sub", size, [&]() { return (left - right).getArr().size(); });
+    }
+    if (suite.selected("mul")) {
+      suite.run("mul", size, [&]() { return (left * right).getArr().size(); });
+    }
+    if (suite.selected("to_string")) {
+      suite.run("to_string", size, [&]() { return left.toString().size(); });
+    }
+    if (suite.selected("parse")) {
+      std::string str = generator.digits(size);
+      suite.run(
+              "parse", size, [&]() { return BigInteger(str).getArr().size(); },
+              str.size());
+    }
+  }
+  for (size_t size : Sizes(1, std::min(kQuadraticLimit, max_limbs))) {
+    Generator generator(size);
+    BigInteger dividend = generator.number(2 * size);
+    BigInteger divisor = generator.number(size, true);
+    if (suite.selected("div")) {
+      suite.run("div", size,
+                [&]() { return (dividend / divisor).getArr().size(); });
+    }
+    if (suite.selected("mod")) {
+      suite.run("mod", size,
+                [&]() { return (dividend % divisor).getArr().size(); });
+    }
+    if (suite.selected("gcd")) {
+      BigInteger factor = generator.number(size / 2 + 1);
+      BigInteger left = generator.number(size) * factor;
+      BigInteger right = generator.number(size) * factor;
+      suite.run("gcd", size, [&]() {
+        return BigInteger::gcd(left, right).getArr().size();
+      });
+    }
+  }
+  for (size_t bits : {2048, 4096, 8192}) {
+    Generator generator(bits);
+    if (suite.selected("pow")) {
+      BigInteger base = generator.bits(bits / 64);
+      suite.run("pow", bits, [&]() {
+        return BigInteger::pow(base, 64).getArr().size();
+      });
+    }
+    if (suite.selected("powmod")) {
+      BigInteger base = generator.bits(bits);
+      BigInteger exponent = generator.bits(bits);
+      BigInteger modulus = generator.bits(bits);
+      suite.run("powmod", bits, [&]() {
+        return BigInteger::powmod(base, exponent, modulus).getArr().size();
+      });
+    }
+    if (suite.selected("isqrt")) {
+      BigInteger value = generator.bits(bits);
+      suite.run("isqrt", bits, [&]() {
+        return BigInteger::isqrt(value).getArr().size();
+      });
+    }
+  }
+}
+
+void ThreadBenchmarks(BenchmarkSuite& suite, size_t threads) {
+  const size_t kScalingLimbs = 1000000;
+  const size_t kMaxThreads = 32;
+  if (!suite.selected("mul_threads") && !suite.selected("to_string_threads")) {
+    return;
+  }
+  size_t limbs = std::min(kScalingLimbs, suite.limit("max-limbs"));
+  suite.describe("scaling_limbs", std::to_string(limbs));
+  Generator generator(limbs);
+  BigInteger left = generator.number(limbs);
+  BigInteger right = generator.number(limbs, true);
+  for (size_t count = 1; count <= kMaxThreads; count *= 2) {
+    BigInteger::setThreadCount(count);
+    if (suite.selected("mul_threads")) {
+      suite.run("mul_threads", count,
+                [&]() { return (left * right).getArr().size(); });
+    }
+    if (suite.selected("to_string_threads")) {
+      suite.run("to_string_threads", count,
+                [&]() { return left.toString().size(); });
+    }
+  }
+  BigInteger::setThreadCount(threads);
+}
+
+void SmallValueBenchmarks(BenchmarkSuite& suite) {
+  for (size_t count : {1000, 1000000}) {
+    if (suite.selected("counter_increment")) {
+      suite.run("counter_increment", count, [&]() {
+        BigInteger counter;
+        for (size_t i = 0; i < count; ++i) {
+          ++counter;
+        }
+        return counter.getArr().size();
+      });
+    }
+    if (suite.selected("accumulate_small")) {
+      Generator generator(count);
+      std::vector<long long> values(count);
+      for (auto& value : values) {
+        value = static_cast<long long>(generator.below(2000001)) - 1000000;
+      }
+      suite.run("accumulate_small", count, [&]() {
+        BigInteger sum;
+        for (long long value : values) {
+          sum += value;
+          sum = sum - value / 2;
+        }
+        return sum.getArr().size();
+      });
+    }
+  }
+}
+
+void FusedBenchmarks(BenchmarkSuite& suite) {
+  const size_t kFusedLimit = 1000;
+  size_t max_limbs = suite.limit("max-limbs");
+  for (size_t size : Sizes(1, std::min(kFusedLimit, max_limbs))) {
+    Generator generator(size);
+    BigInteger left = generator.number(size);
+    BigInteger right = generator.number(size, true);
+    BigInteger other_left = generator.number(size, true);
+    BigInteger other_right = generator.number(size);
+    BigInteger result;
+    if (suite.selected("fused_operators")) {
+      suite.run("fused_operators", size, [&]() {
+        result = left * right + other_left * other_right;
+        return result.getArr().size();
+      });
+    }
+    if (suite.selected("fused_fma")) {
+      suite.run("fused_fma", size, [&]() {
+        BigInteger::mul(result, left, right);
+        BigInteger::fma(result, other_left, other_right);
+        return result.getArr().size();
+      });
+    }
+  }
+}
+
+void BatchBenchmarks(BenchmarkSuite& suite) {
+  const size_t kLanes = 100000;
+  const size_t kBits = 256;
+  Generator generator(kLanes);
+  std::vector<BigInteger> left(kLanes);
+  std::vector<BigInteger> right(kLanes);
+  std::vector<BigInteger> scalar(kLanes);
+  UIntArray<kBits> batch_left(kLanes);
+  UIntArray<kBits> batch_right(kLanes);
+  UIntArray<kBits> batch(kLanes);
+  for (size_t i = 0; i < kLanes; ++i) {
+    left[i] = generator.bits(kBits);
+    right[i] = generator.bits(kBits);
+    batch_left.set(i, UInt<kBits>(left[i]));
+    batch_right.set(i, UInt<kBits>(right[i]));
+  }
+  if (suite.selected("batch_add")) {
+    suite.run("batch_add", kLanes, [&]() {
+      UIntArray<kBits>::add(batch, batch_left, batch_right);
+      return batch.lane(0)[0];
+    });
+  }
+  if (suite.selected("scalar_add")) {
+    suite.run("scalar_add", kLanes, [&]() {
+      for (size_t i = 0; i < kLanes; ++i) {
+        BigInteger::add(scalar[i], left[i], right[i]);
+      }
+      return scalar[0].getArr().size();
+    });
+  }
+  if (suite.selected("batch_mul")) {
+    suite.run("batch_mul", kLanes, [&]() {
+      UIntArray<kBits>::mul(batch, batch_left, batch_right);
+      return batch.lane(0)[0];
+    });
+  }
+  if (suite.selected("scalar_mul")) {
+    suite.run("scalar_mul", kLanes, [&]() {
+      for (size_t i = 0; i < kLanes; ++i) {
+        BigInteger::mul(scalar[i], left[i], right[i]);
+      }
+      return scalar[0].getArr().size();
+    });
+  }
+}
+
+void RationalBenchmarks(BenchmarkSuite& suite) {
+  for (bool lazy : {false, true}) {
+    Rational::setLazyNormalization(lazy);
+    std::string suffix = lazy ? "_lazy" : "";
+    for (size_t terms : {100, 1000}) {
+      if (suite.selected("rational_harmonic" + suffix)) {
+        suite.run("rational_harmonic" + suffix, terms, [&]() {
+          Rational sum;
+          for (size_t i = 1; i <= terms; ++i) {
+            sum += Rational(1, static_cast<int>(i));
+          }
+          return sum.getDenominator().getArr().size();
+        });
+      }
+      if (suite.selected("rational_exp" + suffix)) {
+        suite.run("rational_exp" + suffix, terms, [&]() {
+          Rational sum = 1;
+          Rational term = 1;
+          for (size_t i = 1; i <= terms; ++i) {
+            term /= static_cast<int>(i);
+            sum += term;
+          }
+          return sum.asDecimal(terms).size();
+        });
+      }
+    }
+  }
+  Rational::setLazyNormalization(false);
+}
+
+void SortBenchmarks(BenchmarkSuite& suite) {
+  for (size_t count : {1000, 100000}) {
+    Generator generator(count);
+    if (suite.selected("sort_biginteger")) {
+      std::vector<BigInteger> values;
+      for (size_t i = 0; i < count; ++i) {
+        values.push_back(generator.number(1 + generator.below(4),
+                                          generator.below(2) == 0));
+      }
+      suite.run("sort_biginteger", count, [&]() {
+        std::vector<BigInteger> copy = values;
+        std::sort(copy.begin(), copy.end());
+        return copy[count / 2].getArr().size();
+      });
+    }
+    if (suite.selected("sort_rational")) {
+      std::vector<Rational> values;
+      for (size_t i = 0; i < count; ++i) {
+        values.emplace_back(generator.number(1 + generator.below(3),
+                                             generator.below(2) == 0),
+                            generator.number(1 + generator.below(3)));
+      }
+      suite.run("sort_rational", count, [&]() {
+        std::vector<Rational> copy = values;
+        std::sort(copy.begin(), copy.end());
+        return copy[count / 2].getDenominator().getArr().size();
+      });
+    }
+  }
+}
+
+bool CheckArithmetic() {
+  const long long kValues[] = {-1000000000007LL, -5, -3, 0, 3, 5,
+                               1000000000007LL};
+  for (long long left : kValues) {
+    for (long long right : kValues) {
+      BigInteger sum = left;
+      sum += BigInteger(right);
+      BigInteger difference = left;
+      difference -= BigInteger(right);
+      BigInteger fused = left;
+      BigInteger::fma(fused, right, right);
+      if (sum != BigInteger(left + right) ||
+          difference != BigInteger(left - right) ||
+          fused != left + BigInteger(right) * right) {
+        return false;
+      }
+    }
+  }
+  return true;
+}
+
+std::vector<BigInteger::Limb> SchoolbookProduct(const BigInteger& left,
+                                                const BigInteger& right) {
+  using Limb = BigInteger::Limb;
+  using DoubleLimb = BigInteger::DoubleLimb;
+  const DoubleLimb base =
+          sizeof(Limb) == 8 ? static_cast<DoubleLimb>(~Limb{0}) + 1
+                            : 1000000000;
+  const auto& first = left.getArr();
+  const auto& second = right.getArr();
+  std::vector<Limb> ans(first.size() + second.size(), 0);
+  for (size_t i = 0; i < second.size(); ++i) {
+    DoubleLimb carry = 0;
+    for (size_t j = 0; j < first.size(); ++j) {
+      DoubleLimb cur = ans[i + j] +
+                       static_cast<DoubleLimb>(second[i]) * first[j] + carry;
+      ans[i + j] = static_cast<Limb>(cur % base);
+      carry = cur / base;
+    }
+    ans[i + first.size()] = static_cast<Limb>(carry);
+  }
+  while (ans.size() > 1 && ans.back() == 0) {
+    ans.pop_back();
+  }
+  return ans;
+}
+
+bool CheckFusedAllocations() {
+  for (size_t size : {1, 10, 20}) {
+    Generator generator(size);
+    BigInteger left = generator.number(size);
+    BigInteger right = generator.number(size, true);
+    for (bool negative : {false, true}) {
+      BigInteger other = generator.number(size, negative);
+      BigInteger result;
+      BigInteger::mul(result, left, right);
+      BigInteger::fma(result, other, right);
+      size_t allocated = allocations.load();
+      BigInteger::mul(result, left, right);
+      BigInteger::fma(result, other, right);
+      if (allocations.load() != allocated ||
+          result != left * right + other * right) {
+        return false;
+      }
+    }
+  }
+  return true;
+}
+
+bool CheckBatch() {
+  const size_t kLanes = 1000;
+  const size_t kBits = 256;
+  Generator generator(kLanes);
+  std::vector<BigInteger> left(kLanes);
+  std::vector<BigInteger> right(kLanes);
+  UIntArray<kBits> batch_left(kLanes);
+  UIntArray<kBits> batch_right(kLanes);
+  for (size_t i = 0; i < kLanes; ++i) {
+    left[i] = generator.bits(kBits - i % 2);
+    right[i] = generator.bits(kBits - i % 3);
+    batch_left.set(i, UInt<kBits>(left[i]));
+    batch_right.set(i, UInt<kBits>(right[i]));
+  }
+  UIntArray<kBits> sum;
+  UIntArray<kBits> product;
+  UIntArray<kBits>::add(sum, batch_left, batch_right);
+  UIntArray<kBits>::mul(product, batch_left, batch_right);
+  for (size_t i = 0; i < kLanes; ++i) {
+    if (sum.get(i) != UInt<kBits>(left[i] + right[i]) ||
+        product.get(i) != UInt<kBits>(left[i] * right[i])) {
+      return false;
+    }
+  }
+  return true;
+}
+
+bool CheckMultiply() {
+  const size_t kSizes[] = {1500, 2100, 4000};
+  for (size_t size : kSizes) {
+    Generator generator(size);
+    std::vector<BigInteger::Limb> ones(size, generator.maxLimb());
+    std::pair<BigInteger, BigInteger> cases[] = {
+            {generator.number(size), generator.number(size + size / 3, true)},
+            {BigIntegerView(ones.data(), ones.size(), false).toBigInteger(),
+             BigIntegerView(ones.data(), ones.size(), true).toBigInteger()}};
+    for (const auto& operands : cases) {
+      BigInteger product = operands.first * operands.second;
+      std::vector<BigInteger::Limb> expected =
+              SchoolbookProduct(operands.first, operands.second);
+      if (!product.isNegative() || product.getArr().size() != expected.size() ||
+          !std::equal(expected.begin(), expected.end(),
+                      product.getArr().data())) {
+        return false;
+      }
+    }
+  }
+  return true;
+}
+
+int main(int argc, char** argv) {
+  Options options;
+  try {
+    options = ParseOptions(argc, argv, {{"max-limbs", 1000000}});
+  } catch (const std::exception& error) {
+    std::cerr << error.what() << "\n";
+    return 1;
+  }
+  if (!CheckArithmetic() || !CheckFusedAllocations() || !CheckMultiply() ||
+      !CheckBatch()) {
+    std::cerr << "BigInteger arithmetic check failed\n";
+    return 1;
+  }
+  BigInteger::setThreadCount(options.threads);
+  BenchmarkSuite suite(options);
+  suite.describe("backend", sizeof(BigInteger::Limb) == 8 ? "\"binary\""
+                                                          : "\"decimal\"");
+  suite.describe("limb_bytes", std::to_string(sizeof(BigInteger::Limb)));
+  IntegerBenchmarks(suite);
+  SmallValueBenchmarks(suite);
+  FusedBenchmarks(suite);
+  BatchBenchmarks(suite);
+  RationalBenchmarks(suite);
+  SortBenchmarks(suite);
+  ThreadBenchmarks(suite, options.threads);
+  suite.print(std::cout);
+}
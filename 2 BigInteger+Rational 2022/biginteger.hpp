@@ -1,22 +1,354 @@
 #pragma once
 
 #include <algorithm>
+#include <array>
+#include <atomic>
+#include <cmath>
+#include <condition_variable>
+#include <cstring>
+#include <deque>
+#include <exception>
+#include <fstream>
+#include <functional>
 #include <iostream>
+#include <limits>
+#include <mutex>
 #include <sstream>
+#include <stdexcept>
 #include <string>
+#include <string_view>
+#include <system_error>
+#include <thread>
+#include <type_traits>
 #include <vector>
 
-void DelStringZeros(std::string& str) {
-  while (str[0] == '0') {
-    str.erase(str.begin());
+#if __has_include(<sys/mman.h>)
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#define BIGINTEGER_HAS_MMAP
+#endif
+
+template <typename T, size_t kInlineSize>
+class SmallVector {
+ public:
+  SmallVector() = default;
+
+  SmallVector(size_t size, const T& value) { assign(size, value); }
+
+  SmallVector(const T* first, const T* last) { insert(end(), first, last); }
+
+  SmallVector(const SmallVector& other)
+          : SmallVector(other.begin(), other.end()) {}
+
+  SmallVector(SmallVector&& other) noexcept { steal(other); }
+
+  SmallVector& operator=(const SmallVector& other);
+
+  SmallVector& operator=(SmallVector&& other) noexcept;
+
+  ~SmallVector() { delete[] heap_; }
+
+  [[nodiscard]] size_t size() const { return size_; }
+
+  [[nodiscard]] size_t capacity() const { return cap_; }
+
+  [[nodiscard]] bool empty() const { return size_ == 0; }
+
+  [[nodiscard]] T* data() { return heap_ != nullptr ? heap_ : inline_; }
+
+  [[nodiscard]] const T* data() const {
+    return heap_ != nullptr ? heap_ : inline_;
+  }
+
+  [[nodiscard]] T* begin() { return data(); }
+
+  [[nodiscard]] const T* begin() const { return data(); }
+
+  [[nodiscard]] T* end() { return data() + size_; }
+
+  [[nodiscard]] const T* end() const { return data() + size_; }
+
+  [[nodiscard]] T& back() { return data()[size_ - 1]; }
+
+  [[nodiscard]] const T& back() const { return data()[size_ - 1]; }
+
+  T& operator[](size_t index) { return data()[index]; }
+
+  const T& operator[](size_t index) const { return data()[index]; }
+
+  void reserve(size_t cap);
+
+  void resize(size_t size, const T& value = T());
+
+  void assign(size_t size, const T& value);
+
+  void push_back(const T& value);
+
+  void pop_back() { --size_; }
+
+  void clear() { size_ = 0; }
+
+  T* insert(const T* pos, size_t count, const T& value);
+
+  T* insert(const T* pos, const T* first, const T* last);
+
+ private:
+  size_t size_{};
+  size_t cap_{kInlineSize};
+  T* heap_{nullptr};
+  T inline_[kInlineSize]{};
+
+  void steal(SmallVector& other);
+};
+
+template <typename T, size_t kInlineSize>
+void SmallVector<T, kInlineSize>::steal(SmallVector& other) {
+  if (other.heap_ != nullptr) {
+    heap_ = other.heap_;
+    cap_ = other.cap_;
+    other.heap_ = nullptr;
+    other.cap_ = kInlineSize;
+  } else {
+    std::copy(other.inline_, other.inline_ + other.size_, inline_);
+  }
+  size_ = other.size_;
+  other.size_ = 0;
+}
+
+template <typename T, size_t kInlineSize>
+SmallVector<T, kInlineSize>& SmallVector<T, kInlineSize>::operator=(
+        const SmallVector& other) {
+  if (this != &other) {
+    reserve(other.size_);
+    std::copy(other.begin(), other.end(), data());
+    size_ = other.size_;
+  }
+  return *this;
+}
+
+template <typename T, size_t kInlineSize>
+SmallVector<T, kInlineSize>& SmallVector<T, kInlineSize>::operator=(
+        SmallVector&& other) noexcept {
+  if (this != &other) {
+    delete[] heap_;
+    heap_ = nullptr;
+    cap_ = kInlineSize;
+    steal(other);
+  }
+  return *this;
+}
+
+template <typename T, size_t kInlineSize>
+void SmallVector<T, kInlineSize>::reserve(size_t cap) {
+  if (cap <= cap_) {
+    return;
+  }
+  T* tmp = new T[cap];
+  std::copy(begin(), end(), tmp);
+  delete[] heap_;
+  heap_ = tmp;
+  cap_ = cap;
+}
+
+template <typename T, size_t kInlineSize>
+void SmallVector<T, kInlineSize>::resize(size_t size, const T& value) {
+  if (size > size_) {
+    if (size > cap_) {
+      reserve(std::max(size, 2 * cap_));
+    }
+    std::fill(end(), data() + size, value);
+  }
+  size_ = size;
+}
+
+template <typename T, size_t kInlineSize>
+void SmallVector<T, kInlineSize>::assign(size_t size, const T& value) {
+  reserve(size);
+  std::fill(data(), data() + size, value);
+  size_ = size;
+}
+
+template <typename T, size_t kInlineSize>
+void SmallVector<T, kInlineSize>::push_back(const T& value) {
+  if (size_ == cap_) {
+    reserve(2 * cap_);
+  }
+  data()[size_++] = value;
+}
+
+template <typename T, size_t kInlineSize>
+T* SmallVector<T, kInlineSize>::insert(const T* pos, size_t count,
+                                       const T& value) {
+  size_t index = pos - begin();
+  resize(size_ + count);
+  std::copy_backward(begin() + index, end() - count, end());
+  std::fill(begin() + index, begin() + index + count, value);
+  return begin() + index;
+}
+
+template <typename T, size_t kInlineSize>
+T* SmallVector<T, kInlineSize>::insert(const T* pos, const T* first,
+                                       const T* last) {
+  size_t index = pos - begin();
+  size_t count = last - first;
+  resize(size_ + count);
+  std::copy_backward(begin() + index, end() - count, end());
+  std::copy(first, last, begin() + index);
+  return begin() + index;
+}
+
+template <typename T, size_t kInlineSize>
+bool operator==(const SmallVector<T, kInlineSize>& left,
+                const SmallVector<T, kInlineSize>& right) {
+  return left.size() == right.size() &&
+         std::equal(left.begin(), left.end(), right.begin());
+}
+
+template <typename T, size_t kInlineSize>
+bool operator!=(const SmallVector<T, kInlineSize>& left,
+                const SmallVector<T, kInlineSize>& right) {
+  return !(left == right);
+}
+
+// A fixed set of workers for fork-join recursion. invoke() queues the
+// second branch and runs the first one itself; if no worker has taken the
+// second branch by then, the caller runs it too. A caller therefore only
+// waits for a branch that is already running, so nested forks cannot
+// deadlock on a pool that is smaller than the recursion.
+class WorkerPool {
+ public:
+  WorkerPool() = default;
+
+  WorkerPool(const WorkerPool&) = delete;
+
+  WorkerPool& operator=(const WorkerPool&) = delete;
+
+  ~WorkerPool() { resize(0); }
+
+  // Not safe while an invoke() is running on another thread.
+  void resize(size_t count);
+
+  [[nodiscard]] size_t size() const { return size_; }
+
+  template <typename First, typename Second>
+  void invoke(First& first, Second& second);
+
+ private:
+  struct Task {
+    std::function<void()> body;
+    std::exception_ptr error;
+    bool done = false;
+  };
+
+  std::mutex mutex_;
+  std::condition_variable ready_;
+  std::condition_variable finished_;
+  std::deque<Task*> tasks_;
+  std::vector<std::thread> workers_;
+  std::atomic<size_t> size_{0};
+  bool stop_ = false;
+
+  void work();
+};
+
+void WorkerPool::resize(size_t count) {
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    stop_ = true;
+  }
+  ready_.notify_all();
+  for (auto& worker : workers_) {
+    worker.join();
+  }
+  workers_.clear();
+  stop_ = false;
+  try {
+    while (workers_.size() < count) {
+      workers_.emplace_back([this]() { work(); });
+    }
+  } catch (const std::system_error&) {
+  }
+  size_ = workers_.size();
+}
+
+template <typename First, typename Second>
+void WorkerPool::invoke(First& first, Second& second) {
+  Task task{std::ref(second), nullptr, false};
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    tasks_.push_back(&task);
+  }
+  ready_.notify_one();
+  std::exception_ptr error;
+  try {
+    first();
+  } catch (...) {
+    error = std::current_exception();
+  }
+  std::unique_lock<std::mutex> lock(mutex_);
+  auto queued = std::find(tasks_.begin(), tasks_.end(), &task);
+  if (queued != tasks_.end()) {
+    tasks_.erase(queued);
+    lock.unlock();
+    if (error == nullptr) {
+      second();
+    }
+  } else {
+    finished_.wait(lock, [&task]() { return task.done; });
+  }
+  if (error != nullptr) {
+    std::rethrow_exception(error);
+  }
+  if (task.error != nullptr) {
+    std::rethrow_exception(task.error);
+  }
+}
+
+void WorkerPool::work() {
+  std::unique_lock<std::mutex> lock(mutex_);
+  while (true) {
+    ready_.wait(lock, [this]() { return stop_ || !tasks_.empty(); });
+    if (stop_) {
+      return;
+    }
+    Task* task = tasks_.front();
+    tasks_.pop_front();
+    lock.unlock();
+    try {
+      task->body();
+    } catch (...) {
+      task->error = std::current_exception();
+    }
+    lock.lock();
+    task->done = true;
+    finished_.notify_all();
   }
 }
 
 class BigInteger {
+  __extension__ using UnsignedWide = unsigned __int128;
+  __extension__ using SignedWide = __int128;
+
  public:
+#ifdef BIGINTEGER_BINARY_LIMBS
+  using Limb = unsigned long long;
+  using DoubleLimb = UnsignedWide;
+#else
+  using Limb = unsigned;
+  using DoubleLimb = unsigned long long;
+#endif
+  using Digits = SmallVector<Limb, 2>;
+
   BigInteger();
 
-  BigInteger(std::string str);
+  BigInteger(std::string_view str);
+
+  template <typename String,
+            typename = std::enable_if_t<
+                    std::is_convertible_v<const String&, std::string_view>>>
+  BigInteger(const String& str) : BigInteger(std::string_view(str)) {}
 
   BigInteger(long long value);
 
@@ -46,29 +378,249 @@ class BigInteger {
 
   BigInteger& operator%=(const BigInteger& value);
 
+  BigInteger& operator+=(long long value);
+
+  BigInteger& operator-=(long long value);
+
+  BigInteger& operator*=(long long value);
+
+  BigInteger& operator/=(long long value);
+
+  BigInteger& operator%=(long long value);
+
   explicit operator bool() { return digits_[0] != 0; };
 
   static BigInteger gcd(BigInteger left, BigInteger right);
 
+  static BigInteger extendedGcd(const BigInteger& left,
+                                const BigInteger& right, BigInteger& x,
+                                BigInteger& y);
+
+  static BigInteger pow(const BigInteger& base, unsigned long long exponent);
+
+  static BigInteger powmod(const BigInteger& base, const BigInteger& exponent,
+                           const BigInteger& modulus);
+
+  static BigInteger isqrt(const BigInteger& value);
+
+  static BigInteger iroot(const BigInteger& value, unsigned long long degree);
+
+  static std::pair<BigInteger, BigInteger> divmod(const BigInteger& left,
+                                                  const BigInteger& right);
+
   bool isNegative() const { return is_negative_; }
 
-  const std::vector<int>& getArr() const { return digits_; }
+  const Digits& getArr() const { return digits_; }
+
+  double logAbs() const;
+
+  static double ratioToDouble(const BigInteger& nominator,
+                              const BigInteger& denominator);
 
   static BigInteger abs(const BigInteger& value);
 
+  void writeBinary(std::ostream& ostream) const;
+
+  static BigInteger readBinary(std::istream& istream);
+
+  static void writeArray(std::ostream& ostream,
+                         const std::vector<BigInteger>& values);
+
   static void swap(BigInteger& left, BigInteger& right);
 
+  static void add(BigInteger& dst, const BigInteger& left,
+                  const BigInteger& right);
+
+  static void sub(BigInteger& dst, const BigInteger& left,
+                  const BigInteger& right);
+
+  static void mul(BigInteger& dst, const BigInteger& left,
+                  const BigInteger& right);
+
+  static void fma(BigInteger& dst, const BigInteger& left,
+                  const BigInteger& right);
+
+  static void setThreadCount(size_t count);
+
+  static size_t threadCount();
+
  private:
+#ifdef BIGINTEGER_BINARY_LIMBS
+  static constexpr DoubleLimb kBase = static_cast<DoubleLimb>(1) << 64;
+  static const int kBaseLength = 19;
+  static constexpr Limb kDecimalBase = 10000000000000000000ULL;
+  static const size_t kNttDigitsPerLimb = 2;
+  static const unsigned long long kNttBase = 1ULL << 32;
+  static const size_t kKaratsubaLimit = 24;
+  static const size_t kNttLimit = 1024;
+  using SignedDoubleLimb = SignedWide;
+  static const unsigned long long kLehmerLimit = 1ULL << 62;
+  static const unsigned kLehmerRadix = 2;
+#else
+  static constexpr DoubleLimb kBase = 1000000000;
   static const int kBaseLength = 9;
-  static const int kBase = 1000000000;
+  static constexpr Limb kDecimalBase = 1000000000;
+  static const size_t kNttDigitsPerLimb = 1;
+  static const unsigned long long kNttBase = 1000000000;
+  static const size_t kKaratsubaLimit = 32;
+  static const size_t kNttLimit = 768;
+  using SignedDoubleLimb = long long;
+  static const unsigned long long kLehmerLimit = 1ULL << 31;
+  static const unsigned kLehmerRadix = 10;
+#endif
+  static const size_t kNttMaxLength = 1 << 23;
+  static const int kNttShift = 32;
+  static const unsigned kNttMod1 = 998244353;
+  static const unsigned kNttMod2 = 167772161;
+  static const unsigned kNttMod3 = 469762049;
+  static const unsigned kNttRoot = 3;
+  static const size_t kConversionLimit = 64;
+  static const size_t kReciprocalLimit = 32;
+  static const size_t kParallelLimit = 512;
+  static const size_t kSwarDigits = 8;
+  static const unsigned long long kSwarBase = 100000000;
+  static const size_t kRecordAlignment = 8;
+  static constexpr size_t kReadChunk = 1 << 16;
+  static constexpr char kArrayMagic[] = "BIGINTS";
+  static constexpr unsigned long long kByteOrderMark = 0x0102030405060708ULL;
+  static const long long kRatioBits = 58;
+  static constexpr double kDoubleMaxExponent = 1030;
+  static constexpr double kDoubleMinExponent = -1080;
   bool is_negative_ = false;
-  std::vector<int> digits_;
+  Digits digits_;
+
+  static void addDigits(Digits& dst, const Limb* src, size_t size,
+                        size_t offset);
+
+  static void subDigits(Digits& dst, const Limb* src, size_t size);
+
+  static void addMagnitudes(Digits& dst, const Digits& left,
+                            const Digits& right);
+
+  static void subMagnitudes(Digits& dst, const Digits& left,
+                            const Digits& right);
+
+  static void addSigned(BigInteger& dst, const BigInteger& left,
+                        const BigInteger& right, bool right_negative);
+
+  static bool isShort(long long value);
+
+  void addShort(Limb value, bool negative);
+
+  bool isZero() const { return digits_.size() == 1 && digits_[0] == 0; }
+
+  static int compareDigits(const Digits& left, const Digits& right);
+
+  static Limb divideShort(Digits& digits, Limb divisor);
+
+  static void multiplyAddShort(Digits& digits, Limb factor, Limb addend);
+
+  static void divideDigits(const Digits& left, const Digits& right,
+                           Digits& quotient, Digits& remainder);
+
+  static DoubleLimb toDoubleLimb(const Digits& digits);
+
+  static BigInteger fromDoubleLimb(DoubleLimb value);
+
+  static DoubleLimb gcdShort(DoubleLimb left, DoubleLimb right);
+
+  static bool lehmerCosequence(const Digits& left, const Digits& right,
+                               long long* cosequence);
+
+  static void linearCombination(Digits& dst, const Digits& left,
+                                long long left_factor, const Digits& right,
+                                long long right_factor);
+
+  static Digits multiplyDigits(const Limb* left, size_t left_size,
+                               const Limb* right, size_t right_size);
+
+  static void multiplySchoolbook(Digits& ans, const Limb* left,
+                                 size_t left_size, const Limb* right,
+                                 size_t right_size);
+
+  static void multiplyAccumulate(Digits& dst, const Limb* left,
+                                 size_t left_size, const Limb* right,
+                                 size_t right_size);
+
+  static Digits multiplyKaratsuba(const Limb* left, size_t left_size,
+                                  const Limb* right, size_t right_size);
+
+  static Digits multiplyNtt(const Limb* left, size_t left_size,
+                            const Limb* right, size_t right_size);
+
+  static WorkerPool& workerPool();
+
+  template <typename First, typename Second>
+  static void parallelInvoke(size_t size, First first, Second second);
+
+  static unsigned nttPower(unsigned long long base, unsigned long long exp,
+                           unsigned mod);
+
+  template <unsigned kMod>
+  static void ntt(std::vector<unsigned>& values, bool invert);
+
+  template <unsigned kMod>
+  static std::vector<unsigned> nttConvolution(
+          const std::vector<unsigned>& left, const std::vector<unsigned>& right,
+          size_t size);
+
+  static void trimDigits(Digits& digits);
+
+  static Digits dropDigits(const Digits& digits, size_t count);
+
+  static Digits reciprocalDigits(const Digits& divisor);
+
+  static const Digits& decimalPower(size_t level);
+
+  static const Digits& decimalPowerReciprocal(size_t level);
+
+  static void divideByDecimalPower(const Digits& digits, size_t level,
+                                   Digits& quotient, Digits& remainder);
+
+  static void barrettDivide(const Digits& digits, const Digits& divisor,
+                            const Digits& inverse, Digits& quotient,
+                            Digits& remainder);
+
+  static std::vector<bool> binaryDigits(Digits digits);
+
+  template <typename Reduce>
+  static BigInteger powerWindow(const BigInteger& base,
+                                const std::vector<bool>& bits, Reduce reduce);
+
+  static BigInteger rootDigits(const Digits& digits,
+                               unsigned long long degree);
+
+  static unsigned long long parseEight(const char* str);
+
+  static Limb parseChunk(const char* str, size_t size);
+
+  static Digits toDecimalChunks(Digits digits);
+
+  static Digits fromDecimalChunks(const Digits& chunks);
 
   void removeLeadZeros();
 
   void shiftRight();
 
   void reverse();
+
+  static unsigned long long recordHeader(size_t size, bool negative);
+
+  static size_t recordPadding(size_t size);
+
+  static bool isCanonical(const Limb* limbs, size_t size, bool negative);
+
+  static bool hasBytes(std::istream& istream, size_t count, bool& seekable);
+
+  template <size_t kBits>
+  friend class ModContext;
+
+  template <size_t kBits>
+  friend class UInt;
+
+  friend class BigIntegerView;
+
+  friend class MappedBigIntegers;
 };
 
 void BigInteger::removeLeadZeros() {
@@ -105,336 +657,2410 @@ void BigInteger::swap(BigInteger& left, BigInteger& right) {
 
 BigInteger::BigInteger() { digits_.push_back(0); }
 
-BigInteger::BigInteger(std::string str) {
-  if (str[0] == '-') {
+BigInteger::BigInteger(std::string_view str) {
+  size_t begin = 0;
+  if (!str.empty() && str[0] == '-') {
     is_negative_ = true;
-    str.erase(str.begin());
+    begin = 1;
+  }
+  if (begin == str.size()) {
+    throw std::invalid_argument("Empty number");
+  }
+  while (begin + 1 < str.size() && str[begin] == '0') {
+    ++begin;
+  }
+  size_t length = str.size() - begin;
+  digits_.resize((length + kBaseLength - 1) / kBaseLength);
+  size_t end = str.size();
+  for (size_t i = 0; i < digits_.size(); ++i) {
+    size_t first = end - begin > kBaseLength ? end - kBaseLength : begin;
+    digits_[i] = parseChunk(str.data() + first, end - first);
+    end = first;
+  }
+  if constexpr (kBase != kDecimalBase) {
+    digits_ = fromDecimalChunks(digits_);
+  }
+  if (isZero()) {
+    is_negative_ = false;
+  }
+}
+
+unsigned long long BigInteger::parseEight(const char* str) {
+  unsigned long long chunk = 0;
+  std::memcpy(&chunk, str, sizeof(chunk));
+#if defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_BIG_ENDIAN__
+  chunk = __builtin_bswap64(chunk);
+#endif
+  const unsigned long long zeros = 0x3030303030303030ULL;
+  const unsigned long long high = 0xF0F0F0F0F0F0F0F0ULL;
+  const unsigned long long six = 0x0606060606060606ULL;
+  if ((chunk & high) != zeros || ((chunk + six) & high) != zeros) {
+    throw std::invalid_argument("Invalid digit");
+  }
+  chunk -= zeros;
+  chunk = (chunk * 10 + (chunk >> 8)) & 0x00FF00FF00FF00FFULL;
+  chunk = (chunk * 100 + (chunk >> 16)) & 0x0000FFFF0000FFFFULL;
+  return (chunk * 10000 + (chunk >> 32)) & 0xFFFFFFFFULL;
+}
+
+BigInteger::Limb BigInteger::parseChunk(const char* str, size_t size) {
+  unsigned long long ans = 0;
+  size_t head = size % kSwarDigits;
+  for (size_t i = 0; i < head; ++i) {
+    unsigned digit = static_cast<unsigned char>(str[i]) - '0';
+    if (digit > 9) {
+      throw std::invalid_argument("Invalid digit");
+    }
+    ans = ans * 10 + digit;
+  }
+  for (size_t i = head; i < size; i += kSwarDigits) {
+    ans = ans * kSwarBase + parseEight(str + i);
+  }
+  return static_cast<Limb>(ans);
+}
+
+BigInteger::BigInteger(long long value) : is_negative_(value < 0) {
+  unsigned long long tmp = value < 0 ? 0ULL - value : value;
+  do {
+    digits_.push_back(static_cast<Limb>(tmp % kBase));
+    tmp /= kBase;
+  } while (tmp != 0);
+}
+
+void BigInteger::trimDigits(Digits& digits) {
+  while (digits.size() > 1 && digits.back() == 0) {
+    digits.pop_back();
+  }
+}
+
+BigInteger::Digits BigInteger::dropDigits(const Digits& digits,
+                                          size_t count) {
+  if (count >= digits.size()) {
+    return Digits(1, 0);
+  }
+  return Digits(digits.begin() + count, digits.end());
+}
+
+BigInteger::Digits BigInteger::reciprocalDigits(const Digits& divisor) {
+  size_t size = divisor.size();
+  Digits power(2 * size + 1, 0);
+  power.back() = 1;
+  Limb one = 1;
+  if (size <= kReciprocalLimit) {
+    Digits quotient;
+    Digits remainder;
+    divideDigits(power, divisor, quotient, remainder);
+    trimDigits(quotient);
+    return quotient;
+  }
+  size_t half = size / 2 + 2;
+  Digits head = dropDigits(divisor, size - half);
+  addDigits(head, &one, 1, 0);
+  Digits approx;
+  if (head.size() > half) {
+    approx.assign(half + 1, 0);
+    approx.back() = 1;
+  } else {
+    approx = reciprocalDigits(head);
+  }
+  approx.insert(approx.begin(), size - half, 0);
+  Digits product = multiplyDigits(divisor.data(), size, approx.data(),
+                                  approx.size());
+  trimDigits(product);
+  Digits error = power;
+  subDigits(error, product.data(), product.size());
+  trimDigits(error);
+  product = multiplyDigits(approx.data(), approx.size(), error.data(),
+                           error.size());
+  product = dropDigits(product, 2 * size);
+  addDigits(approx, product.data(), product.size(), 0);
+  trimDigits(approx);
+  product = multiplyDigits(divisor.data(), size, approx.data(), approx.size());
+  trimDigits(product);
+  Digits rest = power;
+  subDigits(rest, product.data(), product.size());
+  trimDigits(rest);
+  while (compareDigits(rest, divisor) >= 0) {
+    subDigits(rest, divisor.data(), size);
+    trimDigits(rest);
+    addDigits(approx, &one, 1, 0);
+  }
+  return approx;
+}
+
+const BigInteger::Digits& BigInteger::decimalPower(size_t level) {
+  static std::deque<Digits> powers(1, Digits(1, kDecimalBase));
+  static std::mutex mutex;
+  std::lock_guard<std::mutex> lock(mutex);
+  while (powers.size() <= level) {
+    const Digits& last = powers.back();
+    Digits next =
+            multiplyDigits(last.data(), last.size(), last.data(), last.size());
+    trimDigits(next);
+    powers.push_back(std::move(next));
   }
-  DelStringZeros(str);
-  int end = static_cast<int>(str.length()) - 1;
-  int size = kBaseLength;
-  while (end >= 0) {
-    if (end - kBaseLength + 1 < 0) {
-      size = end + 1;
-      end = kBaseLength - 1;
+  return powers[level];
+}
+
+const BigInteger::Digits& BigInteger::decimalPowerReciprocal(size_t level) {
+  static std::deque<Digits> reciprocals;
+  static std::mutex mutex;
+  std::lock_guard<std::mutex> lock(mutex);
+  while (reciprocals.size() <= level) {
+    reciprocals.emplace_back();
+  }
+  if (reciprocals[level].empty()) {
+    reciprocals[level] = reciprocalDigits(decimalPower(level));
+  }
+  return reciprocals[level];
+}
+
+void BigInteger::divideByDecimalPower(const Digits& digits, size_t level,
+                                      Digits& quotient, Digits& remainder) {
+  barrettDivide(digits, decimalPower(level), decimalPowerReciprocal(level),
+                quotient, remainder);
+}
+
+void BigInteger::barrettDivide(const Digits& digits, const Digits& divisor,
+                               const Digits& inverse, Digits& quotient,
+                               Digits& remainder) {
+  size_t size = divisor.size();
+  Digits top = dropDigits(digits, size - 1);
+  Digits product = multiplyDigits(top.data(), top.size(), inverse.data(),
+                                  inverse.size());
+  quotient = dropDigits(product, size + 1);
+  trimDigits(quotient);
+  product = multiplyDigits(quotient.data(), quotient.size(), divisor.data(),
+                           size);
+  trimDigits(product);
+  remainder = digits;
+  subDigits(remainder, product.data(), product.size());
+  trimDigits(remainder);
+  Limb one = 1;
+  while (compareDigits(remainder, divisor) >= 0) {
+    subDigits(remainder, divisor.data(), size);
+    trimDigits(remainder);
+    addDigits(quotient, &one, 1, 0);
+  }
+}
+
+BigInteger::Digits BigInteger::toDecimalChunks(Digits digits) {
+  if (digits.size() > kConversionLimit) {
+    size_t level = 0;
+    while (2 * decimalPower(level).size() < digits.size()) {
+      ++level;
+    }
+    Digits quotient;
+    Digits remainder;
+    divideByDecimalPower(digits, level, quotient, remainder);
+    Digits chunks;
+    Digits high;
+    parallelInvoke(
+            digits.size(),
+            [&]() { chunks = toDecimalChunks(std::move(remainder)); },
+            [&]() { high = toDecimalChunks(std::move(quotient)); });
+    chunks.resize(static_cast<size_t>(1) << level, 0);
+    chunks.insert(chunks.end(), high.begin(), high.end());
+    trimDigits(chunks);
+    return chunks;
+  }
+  Digits chunks;
+  while (digits.size() > 1 || digits[0] != 0) {
+    chunks.push_back(divideShort(digits, kDecimalBase));
+    trimDigits(digits);
+  }
+  if (chunks.empty()) {
+    chunks.push_back(0);
+  }
+  return chunks;
+}
+
+BigInteger::Digits BigInteger::fromDecimalChunks(const Digits& chunks) {
+  if (chunks.size() > kConversionLimit) {
+    size_t level = 0;
+    while ((static_cast<size_t>(2) << level) < chunks.size()) {
+      ++level;
     }
-    digits_.push_back(stoi(str.substr(end - kBaseLength + 1, size)));
-    end -= kBaseLength;
+    size_t half = static_cast<size_t>(1) << level;
+    Digits low;
+    Digits high;
+    parallelInvoke(
+            chunks.size(),
+            [&]() {
+              low = fromDecimalChunks(Digits(chunks.begin(),
+                                             chunks.begin() + half));
+            },
+            [&]() {
+              high = fromDecimalChunks(Digits(chunks.begin() + half,
+                                              chunks.end()));
+            });
+    const Digits& power = decimalPower(level);
+    Digits digits = multiplyDigits(high.data(), high.size(), power.data(),
+                                   power.size());
+    addDigits(digits, low.data(), low.size(), 0);
+    trimDigits(digits);
+    return digits;
+  }
+  Digits digits(1, 0);
+  for (size_t i = chunks.size(); i > 0; --i) {
+    multiplyAddShort(digits, kDecimalBase, chunks[i - 1]);
+  }
+  return digits;
+}
+
+std::string BigInteger::toString() const {
+  if (digits_.empty()) {
+    return "";
   }
   if (digits_.back() == 0) {
-    is_negative_ = false;
+    return "0";
+  }
+  std::string str;
+  if (is_negative_) {
+    str += '-';
+  }
+  Digits chunks;
+  if constexpr (kBase != kDecimalBase) {
+    chunks = toDecimalChunks(digits_);
+  }
+  const Digits& decimal =
+          kBase != kDecimalBase ? chunks : digits_;
+  std::string cstr;
+  for (long long i = static_cast<long long>(decimal.size()) - 1; i >= 0; --i) {
+    cstr = std::to_string(decimal[i]);
+    int cnt = static_cast<int>(cstr.size());
+    while (cnt < kBaseLength && i != static_cast<int>(decimal.size()) - 1) {
+      str += '0';
+      ++cnt;
+    }
+    str += cstr;
+  }
+  return str;
+}
+
+std::ostream& operator<<(std::ostream& ostream, const BigInteger& value) {
+  ostream << value.toString();
+  return ostream;
+}
+
+std::istream& operator>>(std::istream& istream, BigInteger& value) {
+  std::string ans;
+  if (!(istream >> ans)) {
+    return istream;
+  }
+  try {
+    value = BigInteger(ans);
+  } catch (const std::invalid_argument&) {
+    istream.setstate(std::ios::failbit);
+  }
+  return istream;
+}
+
+unsigned long long BigInteger::recordHeader(size_t size, bool negative) {
+  return (static_cast<unsigned long long>(size) << 1) |
+         static_cast<unsigned long long>(negative);
+}
+
+size_t BigInteger::recordPadding(size_t size) {
+  return (kRecordAlignment - size * sizeof(Limb) % kRecordAlignment) %
+         kRecordAlignment;
+}
+
+bool BigInteger::isCanonical(const Limb* limbs, size_t size, bool negative) {
+  if (size == 0 || (size > 1 && limbs[size - 1] == 0)) {
+    return false;
+  }
+  if constexpr (kBase == kDecimalBase) {
+    for (size_t i = 0; i < size; ++i) {
+      if (limbs[i] >= kBase) {
+        return false;
+      }
+    }
+  }
+  return !negative || size > 1 || limbs[0] != 0;
+}
+
+void BigInteger::writeBinary(std::ostream& ostream) const {
+  unsigned long long header = recordHeader(digits_.size(), is_negative_);
+  const char padding[kRecordAlignment] = {};
+  ostream.write(reinterpret_cast<const char*>(&header), sizeof(header));
+  ostream.write(reinterpret_cast<const char*>(digits_.data()),
+                static_cast<std::streamsize>(digits_.size() * sizeof(Limb)));
+  ostream.write(padding,
+                static_cast<std::streamsize>(recordPadding(digits_.size())));
+}
+
+bool BigInteger::hasBytes(std::istream& istream, size_t count,
+                          bool& seekable) {
+  std::streampos pos = istream.tellg();
+  seekable = pos != std::streampos(-1) &&
+             istream.seekg(0, std::ios::end).good();
+  if (!seekable) {
+    istream.clear();
+    return true;
+  }
+  std::streamoff remaining = istream.tellg() - pos;
+  istream.seekg(pos);
+  return remaining >= 0 && static_cast<unsigned long long>(remaining) >= count;
+}
+
+BigInteger BigInteger::readBinary(std::istream& istream) {
+  unsigned long long header = 0;
+  if (!istream.read(reinterpret_cast<char*>(&header), sizeof(header))) {
+    throw std::runtime_error("Truncated BigInteger record");
+  }
+  if (header >> 1 == 0 ||
+      header >> 1 > std::numeric_limits<size_t>::max() / sizeof(Limb)) {
+    throw std::runtime_error("Malformed BigInteger record");
+  }
+  size_t size = static_cast<size_t>(header >> 1);
+  bool seekable = false;
+  if (!hasBytes(istream, size * sizeof(Limb), seekable)) {
+    throw std::runtime_error("Truncated BigInteger record");
+  }
+  BigInteger ans;
+  ans.is_negative_ = (header & 1) != 0;
+  for (size_t read = 0; read < size;) {
+    size_t next = seekable ? size
+                           : std::min(size, std::max(2 * read, kReadChunk));
+    ans.digits_.resize(next);
+    if (!istream.read(reinterpret_cast<char*>(ans.digits_.data() + read),
+                      static_cast<std::streamsize>((next - read) *
+                                                   sizeof(Limb)))) {
+      throw std::runtime_error("Truncated BigInteger record");
+    }
+    read = next;
+  }
+  char padding[kRecordAlignment];
+  if (!istream.read(padding,
+                    static_cast<std::streamsize>(recordPadding(size)))) {
+    throw std::runtime_error("Truncated BigInteger record");
+  }
+  if (!isCanonical(ans.digits_.data(), size, ans.is_negative_)) {
+    throw std::runtime_error("Malformed BigInteger record");
+  }
+  return ans;
+}
+
+void BigInteger::writeArray(std::ostream& ostream,
+                            const std::vector<BigInteger>& values) {
+  char magic[kRecordAlignment];
+  std::copy(kArrayMagic, kArrayMagic + kRecordAlignment - 1, magic);
+  magic[kRecordAlignment - 1] = static_cast<char>(sizeof(Limb));
+  unsigned long long count = values.size();
+  ostream.write(magic, sizeof(magic));
+  ostream.write(reinterpret_cast<const char*>(&kByteOrderMark),
+                sizeof(kByteOrderMark));
+  ostream.write(reinterpret_cast<const char*>(&count), sizeof(count));
+  for (const BigInteger& value : values) {
+    value.writeBinary(ostream);
+  }
+}
+
+BigInteger::operator std::string() const {
+  std::stringstream stringstream;
+  stringstream << *this;
+  return stringstream.str();
+}
+
+bool operator==(const BigInteger& left, const BigInteger& right) {
+  if (left.isNegative() != right.isNegative()) {
+    return false;
+  }
+  if (left.getArr().empty()) {
+    return (right.getArr().empty() ||
+            (right.getArr().size() == 1 && right.getArr()[0] == 0));
+  }
+  if (right.getArr().empty()) {
+    return (left.getArr().size() == 1 && left.getArr()[0] == 0);
+  }
+  if (left.getArr().size() != right.getArr().size()) {
+    return false;
+  }
+  return left.getArr() == right.getArr();
+}
+
+bool operator<(const BigInteger& left, const BigInteger& right) {
+  if (left.isNegative() != right.isNegative()) {
+    return left.isNegative();
+  }
+  bool both_is_negative = left.isNegative();
+
+  if (left.getArr().size() != right.getArr().size()) {
+    return (left.getArr().size() < right.getArr().size()) ^ both_is_negative;
+  }
+  for (long long i = static_cast<long long>(left.getArr().size()) - 1; i >= 0;
+       --i) {
+    if (left.getArr()[i] != right.getArr()[i]) {
+      return (left.getArr()[i] < right.getArr()[i]) ^ both_is_negative;
+    }
+  }
+  return false;
+}
+
+bool operator!=(const BigInteger& left, const BigInteger& right) {
+  return !(left == right);
+}
+
+bool operator<=(const BigInteger& left, const BigInteger& right) {
+  return (left < right || left == right);
+}
+
+bool operator>(const BigInteger& left, const BigInteger& right) {
+  return !(left <= right);
+}
+
+bool operator>=(const BigInteger& left, const BigInteger& right) {
+  return !(left < right);
+}
+
+BigInteger operator""_bi(unsigned long long val) {
+  BigInteger value(val);
+  return value;
+}
+
+BigInteger operator""_bi(const char* val, size_t size) {
+  return BigInteger(std::string_view(val, size));
+}
+
+BigInteger BigInteger::operator+() const { return BigInteger(*this); }
+
+BigInteger BigInteger::operator-() const {
+  BigInteger tmp(*this);
+  tmp.is_negative_ = !tmp.is_negative_;
+  return tmp;
+}
+
+BigInteger operator+(const BigInteger& left, const BigInteger& right) {
+  BigInteger ans;
+  BigInteger::add(ans, left, right);
+  return ans;
+}
+
+BigInteger operator+(BigInteger&& left, const BigInteger& right) {
+  BigInteger::add(left, left, right);
+  return std::move(left);
+}
+
+BigInteger operator-(const BigInteger& left, const BigInteger& right) {
+  BigInteger ans;
+  BigInteger::sub(ans, left, right);
+  return ans;
+}
+
+BigInteger operator-(BigInteger&& left, const BigInteger& right) {
+  BigInteger::sub(left, left, right);
+  return std::move(left);
+}
+
+BigInteger operator*(const BigInteger& left, const BigInteger& right) {
+  BigInteger ans;
+  BigInteger::mul(ans, left, right);
+  return ans;
+}
+
+BigInteger operator+(const BigInteger& left, long long right) {
+  BigInteger ans = left;
+  ans += right;
+  return ans;
+}
+
+BigInteger operator+(BigInteger&& left, long long right) {
+  left += right;
+  return std::move(left);
+}
+
+BigInteger operator+(long long left, const BigInteger& right) {
+  BigInteger ans = right;
+  ans += left;
+  return ans;
+}
+
+BigInteger operator-(const BigInteger& left, long long right) {
+  BigInteger ans = left;
+  ans -= right;
+  return ans;
+}
+
+BigInteger operator-(BigInteger&& left, long long right) {
+  left -= right;
+  return std::move(left);
+}
+
+BigInteger operator-(long long left, const BigInteger& right) {
+  BigInteger ans = -right;
+  ans += left;
+  return ans;
+}
+
+BigInteger operator*(const BigInteger& left, long long right) {
+  BigInteger ans = left;
+  ans *= right;
+  return ans;
+}
+
+BigInteger operator*(long long left, const BigInteger& right) {
+  BigInteger ans = right;
+  ans *= left;
+  return ans;
+}
+
+BigInteger operator/(const BigInteger& left, long long right) {
+  BigInteger ans = left;
+  ans /= right;
+  return ans;
+}
+
+BigInteger operator%(const BigInteger& left, long long right) {
+  BigInteger ans = left;
+  ans %= right;
+  return ans;
+}
+
+BigInteger operator/(const BigInteger& left, const BigInteger& right) {
+  return BigInteger::divmod(left, right).first;
+}
+
+BigInteger operator%(const BigInteger& left, const BigInteger& right) {
+  return BigInteger::divmod(left, right).second;
+}
+
+BigInteger& BigInteger::operator++() { return (*this += 1); }
+
+BigInteger BigInteger::operator++(int) {
+  BigInteger tmp = *this;
+  *this += 1;
+  return tmp;
+}
+
+BigInteger& BigInteger::operator--() { return *this -= 1; }
+
+BigInteger BigInteger::operator--(int) {
+  BigInteger tmp = *this;
+  *this -= 1;
+  return tmp;
+}
+
+BigInteger& BigInteger::operator+=(const BigInteger& value) {
+  add(*this, *this, value);
+  return *this;
+}
+
+BigInteger& BigInteger::operator-=(const BigInteger& value) {
+  sub(*this, *this, value);
+  return *this;
+}
+
+void BigInteger::add(BigInteger& dst, const BigInteger& left,
+                     const BigInteger& right) {
+  addSigned(dst, left, right, right.is_negative_);
+}
+
+void BigInteger::sub(BigInteger& dst, const BigInteger& left,
+                     const BigInteger& right) {
+  addSigned(dst, left, right, !right.is_negative_);
+}
+
+void BigInteger::addSigned(BigInteger& dst, const BigInteger& left,
+                           const BigInteger& right, bool right_negative) {
+  bool left_negative = left.is_negative_;
+  if (left_negative == right_negative) {
+    addMagnitudes(dst.digits_, left.digits_, right.digits_);
+    dst.is_negative_ = left_negative;
+  } else if (compareDigits(left.digits_, right.digits_) >= 0) {
+    subMagnitudes(dst.digits_, left.digits_, right.digits_);
+    dst.is_negative_ = left_negative;
+  } else {
+    subMagnitudes(dst.digits_, right.digits_, left.digits_);
+    dst.is_negative_ = right_negative;
+  }
+  dst.removeLeadZeros();
+}
+
+void BigInteger::mul(BigInteger& dst, const BigInteger& left,
+                     const BigInteger& right) {
+  bool negative = left.is_negative_ != right.is_negative_;
+  const Digits& first = left.digits_;
+  const Digits& second = right.digits_;
+  if (&dst != &left && &dst != &right &&
+      std::min(first.size(), second.size()) < kKaratsubaLimit) {
+    multiplySchoolbook(dst.digits_, first.data(), first.size(), second.data(),
+                       second.size());
+  } else {
+    dst.digits_ = multiplyDigits(first.data(), first.size(), second.data(),
+                                 second.size());
+  }
+  dst.is_negative_ = negative;
+  dst.removeLeadZeros();
+}
+
+void BigInteger::fma(BigInteger& dst, const BigInteger& left,
+                     const BigInteger& right) {
+  if (left.isZero() || right.isZero()) {
+    return;
+  }
+  bool negative = left.is_negative_ != right.is_negative_;
+  const Digits& first = left.digits_;
+  const Digits& second = right.digits_;
+  if (&dst != &left && &dst != &right &&
+      std::min(first.size(), second.size()) < kKaratsubaLimit &&
+      (dst.isZero() || dst.is_negative_ == negative)) {
+    multiplyAccumulate(dst.digits_, first.data(), first.size(), second.data(),
+                       second.size());
+    dst.is_negative_ = negative;
+    dst.removeLeadZeros();
+    return;
+  }
+  thread_local BigInteger product;
+  mul(product, left, right);
+  add(dst, dst, product);
+}
+
+bool BigInteger::isShort(long long value) {
+  unsigned long long magnitude = value < 0 ? 0ULL - value : value;
+  return magnitude < kBase;
+}
+
+void BigInteger::addShort(Limb value, bool negative) {
+  if (negative == is_negative_) {
+    Limb carry = value;
+    for (size_t i = 0; i < digits_.size() && carry != 0; ++i) {
+      DoubleLimb cur = static_cast<DoubleLimb>(digits_[i]) + carry;
+      digits_[i] = static_cast<Limb>(cur % kBase);
+      carry = static_cast<Limb>(cur / kBase);
+    }
+    if (carry != 0) {
+      digits_.push_back(carry);
+    }
+    return;
+  }
+  if (digits_.size() == 1 && digits_[0] < value) {
+    digits_[0] = value - digits_[0];
+    is_negative_ = negative;
+    return;
+  }
+  Limb borrow = value;
+  for (size_t i = 0; borrow != 0; ++i) {
+    if (digits_[i] >= borrow) {
+      digits_[i] -= borrow;
+      borrow = 0;
+    } else {
+      digits_[i] = static_cast<Limb>(digits_[i] + kBase - borrow);
+      borrow = 1;
+    }
+  }
+  removeLeadZeros();
+}
+
+BigInteger& BigInteger::operator+=(long long value) {
+  if (!isShort(value)) {
+    return *this += BigInteger(value);
+  }
+  addShort(static_cast<Limb>(value < 0 ? 0ULL - value : value), value < 0);
+  return *this;
+}
+
+BigInteger& BigInteger::operator-=(long long value) {
+  if (!isShort(value)) {
+    return *this -= BigInteger(value);
+  }
+  addShort(static_cast<Limb>(value < 0 ? 0ULL - value : value), value > 0);
+  return *this;
+}
+
+BigInteger& BigInteger::operator*=(long long value) {
+  if (!isShort(value)) {
+    return *this *= BigInteger(value);
+  }
+  multiplyAddShort(digits_,
+                   static_cast<Limb>(value < 0 ? 0ULL - value : value), 0);
+  is_negative_ = is_negative_ != (value < 0);
+  removeLeadZeros();
+  return *this;
+}
+
+BigInteger& BigInteger::operator/=(long long value) {
+  if (!isShort(value)) {
+    return *this /= BigInteger(value);
+  }
+  divideShort(digits_, static_cast<Limb>(value < 0 ? 0ULL - value : value));
+  is_negative_ = is_negative_ != (value < 0);
+  removeLeadZeros();
+  return *this;
+}
+
+BigInteger& BigInteger::operator%=(long long value) {
+  if (!isShort(value)) {
+    return *this %= BigInteger(value);
+  }
+  Limb rest = divideShort(digits_,
+                          static_cast<Limb>(value < 0 ? 0ULL - value : value));
+  digits_.assign(1, rest);
+  removeLeadZeros();
+  return *this;
+}
+
+BigInteger& BigInteger::operator*=(const BigInteger& value) {
+  mul(*this, *this, value);
+  return *this;
+}
+
+void BigInteger::addDigits(Digits& dst, const Limb* src, size_t size,
+                           size_t offset) {
+  if (dst.size() < offset + size) {
+    dst.resize(offset + size, 0);
+  }
+  Limb carry = 0;
+  for (size_t i = 0; i < size || carry != 0; ++i) {
+    if (offset + i == dst.size()) {
+      dst.push_back(0);
+    }
+    DoubleLimb cur = static_cast<DoubleLimb>(dst[offset + i]) + carry +
+                     (i < size ? src[i] : 0);
+    dst[offset + i] = static_cast<Limb>(cur % kBase);
+    carry = static_cast<Limb>(cur / kBase);
+  }
+}
+
+void BigInteger::subDigits(Digits& dst, const Limb* src, size_t size) {
+  Limb borrow = 0;
+  for (size_t i = 0; i < size || borrow != 0; ++i) {
+    DoubleLimb cur = dst[i] + kBase - (i < size ? src[i] : 0) - borrow;
+    dst[i] = static_cast<Limb>(cur % kBase);
+    borrow = static_cast<Limb>(cur < kBase);
+  }
+}
+
+void BigInteger::addMagnitudes(Digits& dst, const Digits& left,
+                               const Digits& right) {
+  size_t left_size = left.size();
+  size_t right_size = right.size();
+  size_t size = std::max(left_size, right_size);
+  dst.resize(size + 1);
+  const Limb* first = left.data();
+  const Limb* second = right.data();
+  Limb* ans = dst.data();
+  Limb carry = 0;
+  for (size_t i = 0; i < size; ++i) {
+    DoubleLimb cur = static_cast<DoubleLimb>(i < left_size ? first[i] : 0) +
+                     (i < right_size ? second[i] : 0) + carry;
+    ans[i] = static_cast<Limb>(cur % kBase);
+    carry = static_cast<Limb>(cur / kBase);
+  }
+  ans[size] = carry;
+}
+
+void BigInteger::subMagnitudes(Digits& dst, const Digits& left,
+                               const Digits& right) {
+  size_t left_size = left.size();
+  size_t right_size = right.size();
+  dst.resize(left_size);
+  const Limb* first = left.data();
+  const Limb* second = right.data();
+  Limb* ans = dst.data();
+  Limb borrow = 0;
+  for (size_t i = 0; i < left_size; ++i) {
+    DoubleLimb cur =
+            first[i] + kBase - (i < right_size ? second[i] : 0) - borrow;
+    ans[i] = static_cast<Limb>(cur % kBase);
+    borrow = static_cast<Limb>(cur < kBase);
+  }
+}
+
+BigInteger::Digits BigInteger::multiplyDigits(const Limb* left,
+                                              size_t left_size,
+                                              const Limb* right,
+                                              size_t right_size) {
+  if (left_size < right_size) {
+    std::swap(left, right);
+    std::swap(left_size, right_size);
+  }
+  if (right_size < kKaratsubaLimit) {
+    Digits ans;
+    multiplySchoolbook(ans, left, left_size, right, right_size);
+    return ans;
+  }
+  if (right_size >= kNttLimit &&
+      (left_size + right_size) * kNttDigitsPerLimb <= kNttMaxLength) {
+    return multiplyNtt(left, left_size, right, right_size);
+  }
+  if (left_size >= 2 * right_size) {
+    Digits ans(left_size + right_size, 0);
+    for (size_t i = 0; i < left_size; i += right_size) {
+      size_t size = std::min(right_size, left_size - i);
+      Digits part = multiplyDigits(left + i, size, right, right_size);
+      addDigits(ans, part.data(), part.size(), i);
+    }
+    ans.resize(left_size + right_size);
+    return ans;
+  }
+  return multiplyKaratsuba(left, left_size, right, right_size);
+}
+
+void BigInteger::multiplySchoolbook(Digits& ans, const Limb* left,
+                                    size_t left_size, const Limb* right,
+                                    size_t right_size) {
+  ans.reserve(left_size + right_size + 1);
+  ans.assign(left_size + right_size, 0);
+  for (size_t i = 0; i < right_size; ++i) {
+    if (right[i] == 0) {
+      continue;
+    }
+    Limb carry = 0;
+    for (size_t j = 0; j < left_size; ++j) {
+      DoubleLimb cur = ans[i + j] +
+                       static_cast<DoubleLimb>(right[i]) * left[j] + carry;
+      ans[i + j] = static_cast<Limb>(cur % kBase);
+      carry = static_cast<Limb>(cur / kBase);
+    }
+    ans[i + left_size] = carry;
+  }
+}
+
+void BigInteger::multiplyAccumulate(Digits& dst, const Limb* left,
+                                    size_t left_size, const Limb* right,
+                                    size_t right_size) {
+  dst.resize(std::max(dst.size(), left_size + right_size) + 1, 0);
+  Limb* ans = dst.data();
+  for (size_t i = 0; i < right_size; ++i) {
+    if (right[i] == 0) {
+      continue;
+    }
+    Limb carry = 0;
+    for (size_t j = 0; j < left_size; ++j) {
+      DoubleLimb cur = ans[i + j] +
+                       static_cast<DoubleLimb>(right[i]) * left[j] + carry;
+      ans[i + j] = static_cast<Limb>(cur % kBase);
+      carry = static_cast<Limb>(cur / kBase);
+    }
+    for (size_t j = i + left_size; carry != 0; ++j) {
+      DoubleLimb cur = static_cast<DoubleLimb>(ans[j]) + carry;
+      ans[j] = static_cast<Limb>(cur % kBase);
+      carry = static_cast<Limb>(cur / kBase);
+    }
+  }
+}
+
+BigInteger::Digits BigInteger::multiplyKaratsuba(const Limb* left,
+                                                 size_t left_size,
+                                                 const Limb* right,
+                                                 size_t right_size) {
+  size_t half = left_size / 2;
+  Digits low;
+  Digits high;
+  Digits middle;
+  parallelInvoke(
+          left_size,
+          [&]() { low = multiplyDigits(left, half, right, half); },
+          [&]() {
+            parallelInvoke(
+                    left_size,
+                    [&]() {
+                      high = multiplyDigits(left + half, left_size - half,
+                                            right + half, right_size - half);
+                    },
+                    [&]() {
+                      Digits left_sum(left, left + half);
+                      addDigits(left_sum, left + half, left_size - half, 0);
+                      Digits right_sum(right, right + half);
+                      addDigits(right_sum, right + half, right_size - half,
+                                0);
+                      middle = multiplyDigits(left_sum.data(),
+                                              left_sum.size(),
+                                              right_sum.data(),
+                                              right_sum.size());
+                    });
+          });
+  subDigits(middle, low.data(), low.size());
+  subDigits(middle, high.data(), high.size());
+  Digits ans = std::move(low);
+  ans.resize(left_size + right_size, 0);
+  addDigits(ans, middle.data(), middle.size(), half);
+  addDigits(ans, high.data(), high.size(), 2 * half);
+  ans.resize(left_size + right_size);
+  return ans;
+}
+
+void BigInteger::setThreadCount(size_t count) {
+  workerPool().resize(count > 1 ? count - 1 : 0);
+}
+
+size_t BigInteger::threadCount() { return workerPool().size() + 1; }
+
+WorkerPool& BigInteger::workerPool() {
+  static WorkerPool pool;
+  return pool;
+}
+
+template <typename First, typename Second>
+void BigInteger::parallelInvoke(size_t size, First first, Second second) {
+  if (size < kParallelLimit || workerPool().size() == 0) {
+    first();
+    second();
+    return;
+  }
+  workerPool().invoke(first, second);
+}
+
+unsigned BigInteger::nttPower(unsigned long long base, unsigned long long exp,
+                              unsigned mod) {
+  unsigned long long ans = 1;
+  base %= mod;
+  while (exp != 0) {
+    if ((exp & 1) != 0) {
+      ans = ans * base % mod;
+    }
+    base = base * base % mod;
+    exp >>= 1;
+  }
+  return static_cast<unsigned>(ans);
+}
+
+template <unsigned kMod>
+void BigInteger::ntt(std::vector<unsigned>& values, bool invert) {
+  size_t size = values.size();
+  for (size_t i = 1, j = 0; i < size; ++i) {
+    size_t bit = size >> 1;
+    for (; (j & bit) != 0; bit >>= 1) {
+      j ^= bit;
+    }
+    j ^= bit;
+    if (i < j) {
+      std::swap(values[i], values[j]);
+    }
+  }
+  std::vector<unsigned> roots(size / 2);
+  for (size_t len = 2; len <= size; len <<= 1) {
+    unsigned root = nttPower(kNttRoot, (kMod - 1) / len, kMod);
+    if (invert) {
+      root = nttPower(root, kMod - 2, kMod);
+    }
+    roots[0] = 1;
+    for (size_t i = 1; i < len / 2; ++i) {
+      roots[i] = static_cast<unsigned>(roots[i - 1] * 1ULL * root % kMod);
+    }
+    for (size_t i = 0; i < size; i += len) {
+      for (size_t j = 0; j < len / 2; ++j) {
+        unsigned first = values[i + j];
+        unsigned second = static_cast<unsigned>(
+                values[i + j + len / 2] * 1ULL * roots[j] % kMod);
+        values[i + j] = first + second < kMod ? first + second
+                                              : first + second - kMod;
+        values[i + j + len / 2] =
+                first >= second ? first - second : first + kMod - second;
+      }
+    }
+  }
+  if (invert) {
+    unsigned long long inverse = nttPower(size, kMod - 2, kMod);
+    for (auto& value : values) {
+      value = static_cast<unsigned>(value * inverse % kMod);
+    }
+  }
+}
+
+template <unsigned kMod>
+std::vector<unsigned> BigInteger::nttConvolution(
+        const std::vector<unsigned>& left, const std::vector<unsigned>& right,
+        size_t size) {
+  std::vector<unsigned> first(size, 0);
+  std::vector<unsigned> second(size, 0);
+  for (size_t i = 0; i < left.size(); ++i) {
+    first[i] = left[i] % kMod;
+  }
+  for (size_t i = 0; i < right.size(); ++i) {
+    second[i] = right[i] % kMod;
+  }
+  parallelInvoke(
+          size, [&]() { ntt<kMod>(first, false); },
+          [&]() { ntt<kMod>(second, false); });
+  for (size_t i = 0; i < size; ++i) {
+    first[i] = static_cast<unsigned>(first[i] * 1ULL * second[i] % kMod);
+  }
+  ntt<kMod>(first, true);
+  return first;
+}
+
+BigInteger::Digits BigInteger::multiplyNtt(const Limb* left,
+                                           size_t left_size,
+                                           const Limb* right,
+                                           size_t right_size) {
+  std::vector<unsigned> left_digits(left_size * kNttDigitsPerLimb);
+  for (size_t i = 0; i < left_digits.size(); ++i) {
+    left_digits[i] = static_cast<unsigned>(
+            left[i / kNttDigitsPerLimb] >>
+            (kNttShift * (i % kNttDigitsPerLimb)));
+  }
+  std::vector<unsigned> right_digits(right_size * kNttDigitsPerLimb);
+  for (size_t i = 0; i < right_digits.size(); ++i) {
+    right_digits[i] = static_cast<unsigned>(
+            right[i / kNttDigitsPerLimb] >>
+            (kNttShift * (i % kNttDigitsPerLimb)));
+  }
+  size_t size = 1;
+  while (size < left_digits.size() + right_digits.size()) {
+    size <<= 1;
+  }
+  std::vector<unsigned> first;
+  std::vector<unsigned> second;
+  std::vector<unsigned> third;
+  parallelInvoke(
+          size,
+          [&]() {
+            first = nttConvolution<kNttMod1>(left_digits, right_digits, size);
+          },
+          [&]() {
+            parallelInvoke(
+                    size,
+                    [&]() {
+                      second = nttConvolution<kNttMod2>(left_digits,
+                                                        right_digits, size);
+                    },
+                    [&]() {
+                      third = nttConvolution<kNttMod3>(left_digits,
+                                                       right_digits, size);
+                    });
+          });
+  const unsigned long long mod12 = 1ULL * kNttMod1 * kNttMod2;
+  const unsigned long long inverse1 =
+          nttPower(kNttMod1, kNttMod2 - 2, kNttMod2);
+  const unsigned long long inverse12 =
+          nttPower(mod12 % kNttMod3, kNttMod3 - 2, kNttMod3);
+  Digits ans(left_size + right_size, 0);
+  UnsignedWide carry = 0;
+  for (size_t i = 0; i < ans.size() * kNttDigitsPerLimb; ++i) {
+    unsigned long long value = first[i];
+    unsigned long long coef =
+            (second[i] + kNttMod2 - value % kNttMod2) * inverse1 % kNttMod2;
+    value += coef * kNttMod1;
+    coef = (third[i] + kNttMod3 - value % kNttMod3) * inverse12 % kNttMod3;
+    carry += static_cast<UnsignedWide>(coef) * mod12 + value;
+    ans[i / kNttDigitsPerLimb] |= static_cast<Limb>(carry % kNttBase)
+                                  << (kNttShift * (i % kNttDigitsPerLimb));
+    carry /= kNttBase;
+  }
+  return ans;
+}
+
+BigInteger& BigInteger::operator/=(const BigInteger& value) {
+  *this = std::move(divmod(*this, value).first);
+  return *this;
+}
+
+BigInteger& BigInteger::operator%=(const BigInteger& value) {
+  *this = std::move(divmod(*this, value).second);
+  return *this;
+}
+
+std::pair<BigInteger, BigInteger> BigInteger::divmod(const BigInteger& left,
+                                                     const BigInteger& right) {
+  std::pair<BigInteger, BigInteger> ans;
+  divideDigits(left.digits_, right.digits_, ans.first.digits_,
+               ans.second.digits_);
+  ans.first.is_negative_ = left.is_negative_ != right.is_negative_;
+  ans.second.is_negative_ = left.is_negative_;
+  ans.first.removeLeadZeros();
+  ans.second.removeLeadZeros();
+  return ans;
+}
+
+int BigInteger::compareDigits(const Digits& left, const Digits& right) {
+  if (left.size() != right.size()) {
+    return left.size() < right.size() ? -1 : 1;
+  }
+  for (size_t i = left.size(); i > 0; --i) {
+    if (left[i - 1] != right[i - 1]) {
+      return left[i - 1] < right[i - 1] ? -1 : 1;
+    }
+  }
+  return 0;
+}
+
+BigInteger::Limb BigInteger::divideShort(Digits& digits,
+                                         Limb divisor) {
+  DoubleLimb rest = 0;
+  for (size_t i = digits.size(); i > 0; --i) {
+    DoubleLimb cur = digits[i - 1] + rest * kBase;
+    digits[i - 1] = static_cast<Limb>(cur / divisor);
+    rest = cur % divisor;
+  }
+  return static_cast<Limb>(rest);
+}
+
+void BigInteger::multiplyAddShort(Digits& digits, Limb factor,
+                                  Limb addend) {
+  Limb carry = addend;
+  for (auto& digit : digits) {
+    DoubleLimb cur = static_cast<DoubleLimb>(digit) * factor + carry;
+    digit = static_cast<Limb>(cur % kBase);
+    carry = static_cast<Limb>(cur / kBase);
+  }
+  if (carry != 0) {
+    digits.push_back(carry);
+  }
+}
+
+void BigInteger::divideDigits(const Digits& left,
+                              const Digits& right,
+                              Digits& quotient,
+                              Digits& remainder) {
+  size_t size = right.size();
+  while (size > 1 && right[size - 1] == 0) {
+    --size;
+  }
+  if (compareDigits(left, right) < 0) {
+    quotient.assign(1, 0);
+    remainder = left;
+    return;
+  }
+  if (size == 1) {
+    quotient = left;
+    remainder.assign(1, divideShort(quotient, right[0]));
+    return;
+  }
+  Limb norm = static_cast<Limb>(
+          kBase / (static_cast<DoubleLimb>(right[size - 1]) + 1));
+  Digits divisor(right.begin(), right.begin() + size);
+  Digits rest = left;
+  rest.push_back(0);
+  if (norm != 1) {
+    multiplySchoolbook(divisor, right.data(), size, &norm, 1);
+    divisor.resize(size);
+    multiplySchoolbook(rest, left.data(), left.size(), &norm, 1);
+  }
+  quotient.assign(rest.size() - size, 0);
+  DoubleLimb top = divisor[size - 1];
+  DoubleLimb second = divisor[size - 2];
+  for (size_t j = quotient.size(); j > 0; --j) {
+    size_t pos = j - 1;
+    DoubleLimb cur = rest[pos + size] * kBase + rest[pos + size - 1];
+    DoubleLimb qhat = cur / top;
+    DoubleLimb rhat = cur % top;
+    while (qhat >= kBase ||
+           qhat * second > rhat * kBase + rest[pos + size - 2]) {
+      --qhat;
+      rhat += top;
+      if (rhat >= kBase) {
+        break;
+      }
+    }
+    Limb carry = 0;
+    Limb borrow = 0;
+    for (size_t i = 0; i < size; ++i) {
+      DoubleLimb product = qhat * divisor[i] + carry;
+      carry = static_cast<Limb>(product / kBase);
+      DoubleLimb cur_digit = rest[pos + i] + kBase - product % kBase - borrow;
+      rest[pos + i] = static_cast<Limb>(cur_digit % kBase);
+      borrow = static_cast<Limb>(cur_digit < kBase);
+    }
+    DoubleLimb subtrahend = static_cast<DoubleLimb>(carry) + borrow;
+    bool negative = rest[pos + size] < subtrahend;
+    rest[pos + size] =
+            static_cast<Limb>((rest[pos + size] + kBase - subtrahend) % kBase);
+    if (negative) {
+      --qhat;
+      Limb add_carry = 0;
+      for (size_t i = 0; i < size; ++i) {
+        DoubleLimb sum =
+                static_cast<DoubleLimb>(rest[pos + i]) + divisor[i] + add_carry;
+        rest[pos + i] = static_cast<Limb>(sum % kBase);
+        add_carry = static_cast<Limb>(sum / kBase);
+      }
+      rest[pos + size] =
+              static_cast<Limb>((rest[pos + size] + add_carry) % kBase);
+    }
+    quotient[pos] = static_cast<Limb>(qhat);
+  }
+  rest.resize(size);
+  divideShort(rest, norm);
+  remainder = std::move(rest);
+}
+
+BigInteger BigInteger::gcd(BigInteger left, BigInteger right) {
+  left.is_negative_ = false;
+  right.is_negative_ = false;
+  if (compareDigits(left.digits_, right.digits_) < 0) {
+    swap(left, right);
+  }
+  BigInteger first;
+  BigInteger second;
+  long long cosequence[4];
+  while (!right.isZero()) {
+    if (left.digits_.size() <= 2) {
+      return fromDoubleLimb(gcdShort(toDoubleLimb(left.digits_),
+                                     toDoubleLimb(right.digits_)));
+    }
+    if (right.digits_.size() == 1) {
+      Limb rest = divideShort(left.digits_, right.digits_[0]);
+      return fromDoubleLimb(gcdShort(right.digits_[0], rest));
+    }
+    if (lehmerCosequence(left.digits_, right.digits_, cosequence)) {
+      linearCombination(first.digits_, left.digits_, cosequence[0],
+                        right.digits_, cosequence[1]);
+      linearCombination(second.digits_, left.digits_, cosequence[2],
+                        right.digits_, cosequence[3]);
+      swap(left, first);
+      swap(right, second);
+    } else {
+      left %= right;
+      swap(left, right);
+    }
+  }
+  return left;
+}
+
+BigInteger BigInteger::extendedGcd(const BigInteger& left,
+                                   const BigInteger& right, BigInteger& x,
+                                   BigInteger& y) {
+  BigInteger first = abs(left);
+  BigInteger second = abs(right);
+  BigInteger first_factor = 1;
+  BigInteger second_factor = 0;
+  if (compareDigits(first.digits_, second.digits_) < 0) {
+    swap(first, second);
+    swap(first_factor, second_factor);
+  }
+  long long cosequence[4];
+  while (!second.isZero()) {
+    if (first.digits_.size() > 2 &&
+        lehmerCosequence(first.digits_, second.digits_, cosequence)) {
+      BigInteger next_first;
+      BigInteger next_second;
+      linearCombination(next_first.digits_, first.digits_, cosequence[0],
+                        second.digits_, cosequence[1]);
+      linearCombination(next_second.digits_, first.digits_, cosequence[2],
+                        second.digits_, cosequence[3]);
+      swap(first, next_first);
+      swap(second, next_second);
+      next_first = first_factor * cosequence[0];
+      next_first += second_factor * cosequence[1];
+      next_second = first_factor * cosequence[2];
+      next_second += second_factor * cosequence[3];
+      swap(first_factor, next_first);
+      swap(second_factor, next_second);
+    } else {
+      std::pair<BigInteger, BigInteger> step = divmod(first, second);
+      swap(first, second);
+      swap(second, step.second);
+      mul(step.second, step.first, second_factor);
+      first_factor -= step.second;
+      swap(first_factor, second_factor);
+    }
+  }
+  x = first_factor;
+  if (right.isZero()) {
+    y = 0;
+  } else {
+    y = first;
+    y -= abs(left) * x;
+    y /= abs(right);
+  }
+  x.is_negative_ = x.is_negative_ != left.is_negative_;
+  y.is_negative_ = y.is_negative_ != right.is_negative_;
+  x.removeLeadZeros();
+  y.removeLeadZeros();
+  return first;
+}
+
+BigInteger BigInteger::pow(const BigInteger& base,
+                           unsigned long long exponent) {
+  std::vector<bool> bits;
+  for (; exponent != 0; exponent >>= 1) {
+    bits.push_back((exponent & 1) != 0);
+  }
+  return powerWindow(base, bits, [](BigInteger&) {});
+}
+
+BigInteger BigInteger::powmod(const BigInteger& base,
+                              const BigInteger& exponent,
+                              const BigInteger& modulus) {
+  BigInteger mod = abs(modulus);
+  if (mod.isZero()) {
+    throw std::domain_error("Zero modulus");
+  }
+  BigInteger start = base % mod;
+  if (start.is_negative_) {
+    start += mod;
+  }
+  if (exponent.is_negative_) {
+    BigInteger x;
+    BigInteger y;
+    if (extendedGcd(start, mod, x, y) != 1) {
+      throw std::domain_error("Base is not invertible");
+    }
+    start = x % mod;
+    if (start.is_negative_) {
+      start += mod;
+    }
+  }
+  Digits inverse = reciprocalDigits(mod.digits_);
+  Digits quotient;
+  BigInteger ans = powerWindow(
+          start, binaryDigits(exponent.digits_), [&](BigInteger& value) {
+            barrettDivide(value.digits_, mod.digits_, inverse, quotient,
+                          value.digits_);
+          });
+  if (compareDigits(ans.digits_, mod.digits_) >= 0) {
+    ans = 0;
+  }
+  return ans;
+}
+
+BigInteger BigInteger::isqrt(const BigInteger& value) {
+  return iroot(value, 2);
+}
+
+BigInteger BigInteger::iroot(const BigInteger& value,
+                             unsigned long long degree) {
+  if (degree == 0) {
+    throw std::domain_error("Zero root degree");
+  }
+  if (value.is_negative_ && degree % 2 == 0) {
+    throw std::domain_error("Even root of a negative number");
+  }
+  if (degree == 1 || value.isZero()) {
+    return value;
+  }
+  BigInteger ans = rootDigits(value.digits_, degree);
+  ans.is_negative_ = value.is_negative_;
+  return ans;
+}
+
+std::vector<bool> BigInteger::binaryDigits(Digits digits) {
+  const Limb kChunk = static_cast<Limb>(1) << 30;
+  std::vector<bool> bits;
+  while (digits.size() > 1 || digits[0] != 0) {
+    Limb chunk = divideShort(digits, kChunk);
+    trimDigits(digits);
+    for (int i = 0; i < 30; ++i) {
+      bits.push_back(((chunk >> i) & 1) != 0);
+    }
+  }
+  while (!bits.empty() && !bits.back()) {
+    bits.pop_back();
+  }
+  return bits;
+}
+
+template <typename Reduce>
+BigInteger BigInteger::powerWindow(const BigInteger& base,
+                                   const std::vector<bool>& bits,
+                                   Reduce reduce) {
+  size_t window = 1;
+  if (bits.size() > 24) {
+    window = 3;
+  }
+  if (bits.size() > 128) {
+    window = 4;
+  }
+  if (bits.size() > 768) {
+    window = 5;
+  }
+  std::vector<BigInteger> odd(static_cast<size_t>(1) << (window - 1));
+  odd[0] = base;
+  BigInteger square;
+  if (odd.size() > 1) {
+    mul(square, base, base);
+    reduce(square);
+  }
+  for (size_t i = 1; i < odd.size(); ++i) {
+    mul(odd[i], odd[i - 1], square);
+    reduce(odd[i]);
+  }
+  BigInteger ans = 1;
+  BigInteger tmp;
+  size_t pos = bits.size();
+  while (pos > 0) {
+    size_t low = pos > window ? pos - window : 0;
+    if (!bits[pos - 1]) {
+      low = pos - 1;
+    }
+    while (!bits[low] && low + 1 < pos) {
+      ++low;
+    }
+    size_t index = 0;
+    for (size_t i = pos; i > low; --i) {
+      index = 2 * index + static_cast<size_t>(bits[i - 1]);
+      if (!ans.isZero() && (ans.digits_.size() > 1 || ans.digits_[0] != 1)) {
+        mul(tmp, ans, ans);
+        reduce(tmp);
+        swap(ans, tmp);
+      }
+    }
+    if (index != 0) {
+      mul(tmp, ans, odd[index / 2]);
+      reduce(tmp);
+      swap(ans, tmp);
+    }
+    pos = low;
+  }
+  return ans;
+}
+
+BigInteger BigInteger::rootDigits(const Digits& digits,
+                                  unsigned long long degree) {
+  size_t size = digits.size();
+  size_t shift = size / (2 * degree);
+  BigInteger ans;
+  if (shift == 0 || size <= 4) {
+    double log = std::log(static_cast<double>(digits[size - 1]));
+    if (size > 1) {
+      log = std::log(static_cast<double>(digits[size - 1]) *
+                             static_cast<double>(kBase) +
+                     static_cast<double>(digits[size - 2]));
+      log += static_cast<double>(size - 2) *
+             std::log(static_cast<double>(kBase));
+    }
+    double estimate =
+            std::exp(log / static_cast<double>(degree)) * (1 + 1e-9);
+    if (estimate < 2) {
+      return BigInteger(1);
+    }
+    estimate += 2;
+    ans.digits_.clear();
+    while (estimate >= 1) {
+      double rest = std::fmod(estimate, static_cast<double>(kBase));
+      ans.digits_.push_back(static_cast<Limb>(rest));
+      estimate = (estimate - rest) / static_cast<double>(kBase);
+    }
+  } else {
+    ans = rootDigits(dropDigits(digits, shift * degree), degree);
+    ans += 1;
+    ans.digits_.insert(ans.digits_.begin(), shift, 0);
+  }
+  BigInteger value;
+  value.digits_ = digits;
+  BigInteger next;
+  while (true) {
+    next = value / pow(ans, degree - 1);
+    fma(next, ans, static_cast<long long>(degree - 1));
+    next /= static_cast<long long>(degree);
+    if (compareDigits(next.digits_, ans.digits_) >= 0) {
+      return ans;
+    }
+    swap(ans, next);
+  }
+}
+
+BigInteger::DoubleLimb BigInteger::toDoubleLimb(const Digits& digits) {
+  DoubleLimb value = digits[0];
+  if (digits.size() > 1) {
+    value += static_cast<DoubleLimb>(digits[1]) * kBase;
+  }
+  return value;
+}
+
+BigInteger BigInteger::fromDoubleLimb(DoubleLimb value) {
+  BigInteger ans;
+  ans.digits_[0] = static_cast<Limb>(value % kBase);
+  if (value >= kBase) {
+    ans.digits_.push_back(static_cast<Limb>(value / kBase));
+  }
+  return ans;
+}
+
+BigInteger::DoubleLimb BigInteger::gcdShort(DoubleLimb left,
+                                            DoubleLimb right) {
+  if (left == 0 || right == 0) {
+    return left | right;
+  }
+  int shift = 0;
+  while (((left | right) & 1) == 0) {
+    left >>= 1;
+    right >>= 1;
+    ++shift;
+  }
+  while ((left & 1) == 0) {
+    left >>= 1;
+  }
+  while (right != 0) {
+    while ((right & 1) == 0) {
+      right >>= 1;
+    }
+    if (left > right) {
+      std::swap(left, right);
+    }
+    right -= left;
+  }
+  return left << shift;
+}
+
+bool BigInteger::lehmerCosequence(const Digits& left, const Digits& right,
+                                  long long* cosequence) {
+  size_t size = left.size();
+  DoubleLimb first =
+          static_cast<DoubleLimb>(left[size - 1]) * kBase + left[size - 2];
+  DoubleLimb second = 0;
+  if (right.size() == size) {
+    second = static_cast<DoubleLimb>(right[size - 1]) * kBase;
+  }
+  if (right.size() >= size - 1) {
+    second += right[size - 2];
+  }
+  while (first >= kLehmerLimit) {
+    first /= kLehmerRadix;
+    second /= kLehmerRadix;
+  }
+  long long top = static_cast<long long>(first);
+  long long bottom = static_cast<long long>(second);
+  long long a = 1;
+  long long b = 0;
+  long long c = 0;
+  long long d = 1;
+  while (bottom + c != 0 && bottom + d != 0) {
+    long long quotient = (top + a) / (bottom + c);
+    if (quotient != (top + b) / (bottom + d)) {
+      break;
+    }
+    long long tmp = a - quotient * c;
+    a = c;
+    c = tmp;
+    tmp = b - quotient * d;
+    b = d;
+    d = tmp;
+    tmp = top - quotient * bottom;
+    top = bottom;
+    bottom = tmp;
+  }
+  cosequence[0] = a;
+  cosequence[1] = b;
+  cosequence[2] = c;
+  cosequence[3] = d;
+  return b != 0;
+}
+
+void BigInteger::linearCombination(Digits& dst, const Digits& left,
+                                   long long left_factor,
+                                   const Digits& right,
+                                   long long right_factor) {
+  const SignedDoubleLimb base = static_cast<SignedDoubleLimb>(kBase);
+  size_t size = left.size();
+  dst.resize(size);
+  SignedDoubleLimb carry = 0;
+  for (size_t i = 0; i < size; ++i) {
+    SignedDoubleLimb cur =
+            static_cast<SignedDoubleLimb>(left_factor) * left[i] + carry;
+    if (i < right.size()) {
+      cur += static_cast<SignedDoubleLimb>(right_factor) * right[i];
+    }
+    SignedDoubleLimb digit = cur % base;
+    if (digit < 0) {
+      digit += base;
+    }
+    dst[i] = static_cast<Limb>(digit);
+    carry = (cur - digit) / base;
+  }
+  trimDigits(dst);
+}
+
+double BigInteger::logAbs() const {
+  size_t size = digits_.size();
+  double top = static_cast<double>(digits_[size - 1]);
+  if (size > 1) {
+    top = top * static_cast<double>(kBase) +
+          static_cast<double>(digits_[size - 2]);
+  }
+  double log = std::log(top);
+  if (size > 2) {
+    log += static_cast<double>(size - 2) *
+           std::log(static_cast<double>(kBase));
+  }
+  return log;
+}
+
+double BigInteger::ratioToDouble(const BigInteger& nominator,
+                                 const BigInteger& denominator) {
+  double sign = nominator.is_negative_ != denominator.is_negative_ ? -1 : 1;
+  if (nominator.isZero()) {
+    return 0;
+  }
+  double log = (nominator.logAbs() - denominator.logAbs()) / std::log(2.0);
+  if (log > kDoubleMaxExponent) {
+    return sign * std::numeric_limits<double>::infinity();
+  }
+  if (log < kDoubleMinExponent) {
+    return sign * 0.0;
+  }
+  long long shift = kRatioBits - static_cast<long long>(std::floor(log));
+  BigInteger top = abs(nominator);
+  BigInteger bottom = abs(denominator);
+  BigInteger power = pow(2, static_cast<unsigned long long>(std::abs(shift)));
+  if (shift > 0) {
+    top *= power;
+  } else {
+    bottom *= power;
+  }
+  std::pair<BigInteger, BigInteger> parts = divmod(top, bottom);
+  unsigned long long quotient = 0;
+  for (size_t i = parts.first.digits_.size(); i > 0; --i) {
+    quotient = static_cast<unsigned long long>(quotient * kBase +
+                                               parts.first.digits_[i - 1]);
+  }
+  long long bits = 0;
+  while (bits < 64 && (quotient >> bits) != 0) {
+    ++bits;
+  }
+  long long precision = std::numeric_limits<double>::digits;
+  long long exponent = bits - 1 - shift;
+  const long long min_exponent = std::numeric_limits<double>::min_exponent - 1;
+  if (exponent < min_exponent) {
+    precision -= min_exponent - exponent;
+  }
+  if (precision < 0) {
+    return sign * 0.0;
+  }
+  long long drop = bits - precision;
+  unsigned long long kept = quotient >> drop;
+  unsigned long long rest = quotient - (kept << drop);
+  unsigned long long half = 1ULL << (drop - 1);
+  if (rest > half ||
+      (rest == half && (!parts.second.isZero() || (kept & 1) != 0))) {
+    ++kept;
+  }
+  return sign * std::ldexp(static_cast<double>(kept),
+                           static_cast<int>(drop - shift));
+}
+
+BigInteger BigInteger::abs(const BigInteger& value) {
+  BigInteger tmp = value;
+  tmp.is_negative_ = false;
+  return tmp;
+}
+
+class BigIntegerView {
+ public:
+  using Limb = BigInteger::Limb;
+
+  BigIntegerView(const Limb* limbs, size_t size, bool negative)
+          : limbs_(limbs), size_(size), is_negative_(negative) {}
+
+  bool isNegative() const { return is_negative_; }
+
+  size_t size() const { return size_; }
+
+  const Limb* data() const { return limbs_; }
+
+  Limb operator[](size_t index) const { return limbs_[index]; }
+
+  BigInteger toBigInteger() const;
+
+ private:
+  const Limb* limbs_;
+  size_t size_;
+  bool is_negative_;
+};
+
+BigInteger BigIntegerView::toBigInteger() const {
+  if (!BigInteger::isCanonical(limbs_, size_, is_negative_)) {
+    throw std::runtime_error("Malformed BigInteger record");
+  }
+  BigInteger ans;
+  ans.digits_ = BigInteger::Digits(limbs_, limbs_ + size_);
+  ans.is_negative_ = is_negative_;
+  return ans;
+}
+
+bool operator==(const BigIntegerView& left, const BigIntegerView& right) {
+  return left.isNegative() == right.isNegative() &&
+         left.size() == right.size() &&
+         std::equal(left.data(), left.data() + left.size(), right.data());
+}
+
+bool operator!=(const BigIntegerView& left, const BigIntegerView& right) {
+  return !(left == right);
+}
+
+bool operator<(const BigIntegerView& left, const BigIntegerView& right) {
+  if (left.isNegative() != right.isNegative()) {
+    return left.isNegative();
+  }
+  int cmp = 0;
+  if (left.size() != right.size()) {
+    cmp = left.size() < right.size() ? -1 : 1;
+  }
+  for (size_t i = left.size(); cmp == 0 && i > 0; --i) {
+    if (left[i - 1] != right[i - 1]) {
+      cmp = left[i - 1] < right[i - 1] ? -1 : 1;
+    }
+  }
+  return left.isNegative() ? cmp > 0 : cmp < 0;
+}
+
+class MappedBigIntegers {
+ public:
+  explicit MappedBigIntegers(const std::string& path);
+
+  MappedBigIntegers(const MappedBigIntegers& other) = delete;
+
+  MappedBigIntegers& operator=(const MappedBigIntegers& other) = delete;
+
+  ~MappedBigIntegers();
+
+  size_t size() const { return offsets_.size(); }
+
+  BigIntegerView operator[](size_t index) const;
+
+ private:
+  const char* data_ = nullptr;
+  size_t length_ = 0;
+  void* mapping_ = nullptr;
+  std::vector<char> buffer_;
+  std::vector<size_t> offsets_;
+
+  void load(const std::string& path);
+
+  void index();
+};
+
+MappedBigIntegers::MappedBigIntegers(const std::string& path) {
+  load(path);
+  try {
+    index();
+  } catch (...) {
+#ifdef BIGINTEGER_HAS_MMAP
+    if (mapping_ != nullptr) {
+      munmap(mapping_, length_);
+    }
+#endif
+    throw;
+  }
+}
+
+MappedBigIntegers::~MappedBigIntegers() {
+#ifdef BIGINTEGER_HAS_MMAP
+  if (mapping_ != nullptr) {
+    munmap(mapping_, length_);
+  }
+#endif
+}
+
+void MappedBigIntegers::load(const std::string& path) {
+#ifdef BIGINTEGER_HAS_MMAP
+  int descriptor = open(path.c_str(), O_RDONLY);
+  if (descriptor < 0) {
+    throw std::runtime_error("Cannot open " + path);
+  }
+  struct stat info {};
+  if (fstat(descriptor, &info) != 0 || info.st_size == 0) {
+    close(descriptor);
+    throw std::runtime_error("Cannot map " + path);
+  }
+  length_ = static_cast<size_t>(info.st_size);
+  void* mapping =
+          mmap(nullptr, length_, PROT_READ, MAP_PRIVATE, descriptor, 0);
+  close(descriptor);
+  if (mapping == MAP_FAILED) {
+    throw std::runtime_error("Cannot map " + path);
+  }
+  mapping_ = mapping;
+  data_ = static_cast<const char*>(mapping);
+#else
+  std::ifstream file(path, std::ios::binary);
+  if (!file) {
+    throw std::runtime_error("Cannot open " + path);
+  }
+  buffer_.assign(std::istreambuf_iterator<char>(file),
+                 std::istreambuf_iterator<char>());
+  length_ = buffer_.size();
+  data_ = buffer_.data();
+#endif
+}
+
+void MappedBigIntegers::index() {
+  const size_t alignment = BigInteger::kRecordAlignment;
+  unsigned long long mark = 0;
+  unsigned long long count = 0;
+  if (length_ < 3 * alignment ||
+      !std::equal(BigInteger::kArrayMagic,
+                  BigInteger::kArrayMagic + alignment - 1, data_) ||
+      data_[alignment - 1] != static_cast<char>(sizeof(BigInteger::Limb))) {
+    throw std::runtime_error("Not a BigInteger array");
+  }
+  std::memcpy(&mark, data_ + alignment, sizeof(mark));
+  if (mark != BigInteger::kByteOrderMark) {
+    throw std::runtime_error("BigInteger array has foreign byte order");
+  }
+  std::memcpy(&count, data_ + 2 * alignment, sizeof(count));
+  if (count > (length_ - 3 * alignment) / (2 * alignment)) {
+    throw std::runtime_error("Truncated BigInteger array");
+  }
+  offsets_.reserve(count);
+  size_t offset = 3 * alignment;
+  for (unsigned long long i = 0; i < count; ++i) {
+    unsigned long long header = 0;
+    if (length_ - offset < alignment) {
+      throw std::runtime_error("Truncated BigInteger array");
+    }
+    std::memcpy(&header, data_ + offset, sizeof(header));
+    unsigned long long size = header >> 1;
+    size_t limbs = length_ - offset - alignment;
+    if (size == 0 || size > limbs / sizeof(BigInteger::Limb) ||
+        BigInteger::recordPadding(static_cast<size_t>(size)) >
+                limbs - size * sizeof(BigInteger::Limb)) {
+      throw std::runtime_error("Truncated BigInteger array");
+    }
+    BigInteger::Limb top = 0;
+    std::memcpy(&top,
+                data_ + offset + alignment +
+                        (size - 1) * sizeof(BigInteger::Limb),
+                sizeof(top));
+    if (top == 0 && (size > 1 || (header & 1) != 0)) {
+      throw std::runtime_error("Malformed BigInteger record");
+    }
+    offsets_.push_back(offset);
+    offset += alignment + size * sizeof(BigInteger::Limb) +
+              BigInteger::recordPadding(static_cast<size_t>(size));
+  }
+}
+
+BigIntegerView MappedBigIntegers::operator[](size_t index) const {
+  unsigned long long header = 0;
+  std::memcpy(&header, data_ + offsets_[index], sizeof(header));
+  const char* limbs = data_ + offsets_[index] + BigInteger::kRecordAlignment;
+  return {reinterpret_cast<const BigInteger::Limb*>(limbs),
+          static_cast<size_t>(header >> 1), (header & 1) != 0};
+}
+
+template <size_t kBits>
+class ModContext {
+ public:
+  using Limb = BigInteger::Limb;
+  using DoubleLimb = BigInteger::DoubleLimb;
+#ifdef BIGINTEGER_BINARY_LIMBS
+  static const size_t kLimbs = (kBits + 63) / 64;
+#else
+  static const size_t kLimbs = kBits * 1000 / 29897 + 1;
+#endif
+  using Residue = std::array<Limb, kLimbs>;
+
+  explicit ModContext(const BigInteger& modulus);
+
+  const BigInteger& modulus() const { return modulus_; }
+
+  Residue toMontgomery(const BigInteger& value) const;
+
+  BigInteger fromMontgomery(const Residue& value) const;
+
+  const Residue& one() const { return one_; }
+
+  void mulmod(Residue& dst, const Residue& left, const Residue& right) const;
+
+  void addmod(Residue& dst, const Residue& left, const Residue& right) const;
+
+  void submod(Residue& dst, const Residue& left, const Residue& right) const;
+
+  void powmod(Residue& dst, const Residue& base,
+              const BigInteger& exponent) const;
+
+ private:
+  static const size_t kWindow = 4;
+  static constexpr DoubleLimb kBase = BigInteger::kBase;
+  BigInteger modulus_;
+  Residue digits_{};
+  Residue one_{};
+  Residue square_{};
+  Limb inverse_{};
+
+  bool less(const Residue& left) const;
+
+  void subtract(Residue& dst) const;
+};
+
+template <size_t kBits>
+ModContext<kBits>::ModContext(const BigInteger& modulus)
+        : modulus_(BigInteger::abs(modulus)) {
+  const BigInteger::Digits& digits = modulus_.digits_;
+  if (modulus_.isZero() || digits.size() > kLimbs) {
+    throw std::domain_error("Modulus does not fit the context");
+  }
+  if (BigInteger::gcdShort(digits[0], kBase) != 1) {
+    throw std::domain_error("Modulus is not coprime with the limb base");
+  }
+  std::copy(digits.begin(), digits.end(), digits_.begin());
+  BigInteger x;
+  BigInteger y;
+  BigInteger base = BigInteger::fromDoubleLimb(kBase);
+  BigInteger::extendedGcd(BigInteger::fromDoubleLimb(digits[0]), base, x, y);
+  if (x.is_negative_) {
+    x += base;
+  }
+  inverse_ = static_cast<Limb>(kBase - x.digits_[0]);
+  BigInteger power;
+  power.digits_.assign(2 * kLimbs + 1, 0);
+  power.digits_.back() = 1;
+  BigInteger rest = power % modulus_;
+  std::copy(rest.digits_.begin(), rest.digits_.end(), square_.begin());
+  Residue unit{};
+  unit[0] = 1;
+  mulmod(one_, unit, square_);
+}
+
+template <size_t kBits>
+typename ModContext<kBits>::Residue ModContext<kBits>::toMontgomery(
+        const BigInteger& value) const {
+  BigInteger rest = value % modulus_;
+  if (rest.is_negative_) {
+    rest += modulus_;
+  }
+  Residue plain{};
+  std::copy(rest.digits_.begin(), rest.digits_.end(), plain.begin());
+  Residue ans;
+  mulmod(ans, plain, square_);
+  return ans;
+}
+
+template <size_t kBits>
+BigInteger ModContext<kBits>::fromMontgomery(const Residue& value) const {
+  Residue unit{};
+  unit[0] = 1;
+  Residue plain;
+  mulmod(plain, value, unit);
+  BigInteger ans;
+  ans.digits_ = BigInteger::Digits(plain.data(), plain.data() + kLimbs);
+  ans.removeLeadZeros();
+  return ans;
+}
+
+template <size_t kBits>
+void ModContext<kBits>::mulmod(Residue& dst, const Residue& left,
+                               const Residue& right) const {
+  Limb tmp[kLimbs + 2] = {};
+  for (size_t i = 0; i < kLimbs; ++i) {
+    Limb carry = 0;
+    for (size_t j = 0; j < kLimbs; ++j) {
+      DoubleLimb cur = tmp[j] + static_cast<DoubleLimb>(left[j]) * right[i] +
+                       carry;
+      tmp[j] = static_cast<Limb>(cur % kBase);
+      carry = static_cast<Limb>(cur / kBase);
+    }
+    DoubleLimb cur = static_cast<DoubleLimb>(tmp[kLimbs]) + carry;
+    tmp[kLimbs] = static_cast<Limb>(cur % kBase);
+    tmp[kLimbs + 1] = static_cast<Limb>(cur / kBase);
+    Limb factor = static_cast<Limb>(
+            static_cast<DoubleLimb>(tmp[0]) * inverse_ % kBase);
+    cur = tmp[0] + static_cast<DoubleLimb>(factor) * digits_[0];
+    carry = static_cast<Limb>(cur / kBase);
+    for (size_t j = 1; j < kLimbs; ++j) {
+      cur = tmp[j] + static_cast<DoubleLimb>(factor) * digits_[j] + carry;
+      tmp[j - 1] = static_cast<Limb>(cur % kBase);
+      carry = static_cast<Limb>(cur / kBase);
+    }
+    cur = static_cast<DoubleLimb>(tmp[kLimbs]) + carry;
+    tmp[kLimbs - 1] = static_cast<Limb>(cur % kBase);
+    tmp[kLimbs] = tmp[kLimbs + 1] + static_cast<Limb>(cur / kBase);
+  }
+  std::copy(tmp, tmp + kLimbs, dst.begin());
+  if (tmp[kLimbs] != 0 || !less(dst)) {
+    subtract(dst);
+  }
+}
+
+template <size_t kBits>
+void ModContext<kBits>::addmod(Residue& dst, const Residue& left,
+                               const Residue& right) const {
+  Limb carry = 0;
+  for (size_t i = 0; i < kLimbs; ++i) {
+    DoubleLimb cur = static_cast<DoubleLimb>(left[i]) + right[i] + carry;
+    dst[i] = static_cast<Limb>(cur % kBase);
+    carry = static_cast<Limb>(cur / kBase);
+  }
+  if (carry != 0 || !less(dst)) {
+    subtract(dst);
   }
 }
 
-BigInteger::BigInteger(long long value) : is_negative_(value < 0) {
-  long long tmp = std::abs(value);
-  do {
-    digits_.push_back(static_cast<int>(tmp % kBase));
-    tmp /= kBase;
-  } while (tmp != 0);
+template <size_t kBits>
+void ModContext<kBits>::submod(Residue& dst, const Residue& left,
+                               const Residue& right) const {
+  Limb borrow = 0;
+  for (size_t i = 0; i < kLimbs; ++i) {
+    DoubleLimb cur = left[i] + kBase - right[i] - borrow;
+    dst[i] = static_cast<Limb>(cur % kBase);
+    borrow = static_cast<Limb>(cur < kBase);
+  }
+  if (borrow != 0) {
+    Limb carry = 0;
+    for (size_t i = 0; i < kLimbs; ++i) {
+      DoubleLimb cur = static_cast<DoubleLimb>(dst[i]) + digits_[i] + carry;
+      dst[i] = static_cast<Limb>(cur % kBase);
+      carry = static_cast<Limb>(cur / kBase);
+    }
+  }
 }
 
-std::string BigInteger::toString() const {
-  if (digits_.empty()) {
-    return "";
+template <size_t kBits>
+void ModContext<kBits>::powmod(Residue& dst, const Residue& base,
+                               const BigInteger& exponent) const {
+  if (exponent.is_negative_) {
+    throw std::domain_error("Negative exponent");
   }
-  if (digits_.back() == 0) {
-    return "0";
+  std::array<Residue, 1 << kWindow> table;
+  table[0] = one_;
+  for (size_t i = 1; i < table.size(); ++i) {
+    mulmod(table[i], table[i - 1], base);
   }
-  std::string str;
-  if (is_negative_) {
-    str += '-';
+  std::vector<bool> bits = BigInteger::binaryDigits(exponent.digits_);
+  while (bits.size() % kWindow != 0) {
+    bits.push_back(false);
   }
-  std::string cstr;
-  for (long long i = static_cast<long long>(digits_.size()) - 1; i >= 0; --i) {
-    cstr = std::to_string(digits_[i]);
-    int cnt = static_cast<int>(cstr.size());
-    while (cnt < kBaseLength && i != static_cast<int>(digits_.size()) - 1) {
-      str += '0';
-      ++cnt;
+  Residue ans = one_;
+  for (size_t pos = bits.size(); pos > 0; pos -= kWindow) {
+    size_t index = 0;
+    for (size_t i = pos; i > pos - kWindow; --i) {
+      mulmod(ans, ans, ans);
+      index = 2 * index + static_cast<size_t>(bits[i - 1]);
     }
-    str += cstr;
+    mulmod(ans, ans, table[index]);
   }
-  return str;
+  dst = ans;
 }
 
-std::ostream& operator<<(std::ostream& ostream, const BigInteger& value) {
-  ostream << value.toString();
-  return ostream;
+template <size_t kBits>
+bool ModContext<kBits>::less(const Residue& left) const {
+  for (size_t i = kLimbs; i > 0; --i) {
+    if (left[i - 1] != digits_[i - 1]) {
+      return left[i - 1] < digits_[i - 1];
+    }
+  }
+  return false;
 }
 
-std::istream& operator>>(std::istream& istream, BigInteger& value) {
-  std::string ans;
-  istream >> ans;
-  BigInteger tmp(ans);
-  value = tmp;
-  return istream;
+template <size_t kBits>
+void ModContext<kBits>::subtract(Residue& dst) const {
+  Limb borrow = 0;
+  for (size_t i = 0; i < kLimbs; ++i) {
+    DoubleLimb cur = dst[i] + kBase - digits_[i] - borrow;
+    dst[i] = static_cast<Limb>(cur % kBase);
+    borrow = static_cast<Limb>(cur < kBase);
+  }
 }
 
-BigInteger::operator std::string() const {
-  std::stringstream stringstream;
-  stringstream << *this;
-  return stringstream.str();
+template <size_t kBits>
+class UInt {
+ public:
+  using Word = unsigned;
+  using DoubleWord = unsigned long long;
+  static const int kWordBits = 32;
+  static const size_t kWords = kBits / kWordBits;
+  static_assert(kBits > 0 && kBits % kWordBits == 0,
+                "UInt width must be a positive multiple of 32");
+
+  UInt() = default;
+
+  UInt(unsigned long long value);
+
+  explicit UInt(const BigInteger& value);
+
+  BigInteger toBigInteger() const;
+
+  Word& operator[](size_t index) { return words_[index]; }
+
+  const Word& operator[](size_t index) const { return words_[index]; }
+
+  UInt& operator+=(const UInt& other);
+
+  UInt& operator-=(const UInt& other);
+
+  UInt& operator*=(const UInt& other);
+
+  static int compare(const UInt& left, const UInt& right);
+
+ private:
+  static constexpr BigInteger::Limb kHalfWord = 1U << (kWordBits / 2);
+  std::array<Word, kWords> words_{};
+};
+
+template <size_t kBits>
+UInt<kBits>::UInt(unsigned long long value) {
+  words_[0] = static_cast<Word>(value);
+  if constexpr (kWords > 1) {
+    words_[1] = static_cast<Word>(value >> kWordBits);
+  }
 }
 
-bool operator==(const BigInteger& left, const BigInteger& right) {
-  if (left.isNegative() != right.isNegative()) {
-    return false;
+template <size_t kBits>
+UInt<kBits>::UInt(const BigInteger& value) {
+  BigInteger::Digits digits = value.digits_;
+  for (size_t i = 0; i < kWords && !(digits.size() == 1 && digits[0] == 0);
+       ++i) {
+    Word low = BigInteger::divideShort(digits, kHalfWord);
+    Word high = BigInteger::divideShort(digits, kHalfWord);
+    words_[i] = low | (high << (kWordBits / 2));
+    BigInteger::trimDigits(digits);
   }
-  if (left.getArr().empty()) {
-    return (right.getArr().empty() ||
-            (right.getArr().size() == 1 && right.getArr()[0] == 0));
+  if (value.is_negative_) {
+    *this = UInt() - *this;
   }
-  if (right.getArr().empty()) {
-    return (left.getArr().size() == 1 && left.getArr()[0] == 0);
+}
+
+template <size_t kBits>
+BigInteger UInt<kBits>::toBigInteger() const {
+  BigInteger ans;
+  for (size_t i = kWords; i > 0; --i) {
+    BigInteger::multiplyAddShort(ans.digits_, kHalfWord,
+                                 words_[i - 1] >> (kWordBits / 2));
+    BigInteger::multiplyAddShort(ans.digits_, kHalfWord,
+                                 words_[i - 1] & (kHalfWord - 1));
   }
-  if (left.getArr().size() != right.getArr().size()) {
-    return false;
+  BigInteger::trimDigits(ans.digits_);
+  return ans;
+}
+
+template <size_t kBits>
+UInt<kBits>& UInt<kBits>::operator+=(const UInt& other) {
+  Word carry = 0;
+  for (size_t i = 0; i < kWords; ++i) {
+    DoubleWord cur = static_cast<DoubleWord>(words_[i]) + other[i] + carry;
+    words_[i] = static_cast<Word>(cur);
+    carry = static_cast<Word>(cur >> kWordBits);
   }
-  return left.getArr() == right.getArr();
+  return *this;
 }
 
-bool operator<(const BigInteger& left, const BigInteger& right) {
-  bool both_is_negative = false;
-  if (left == right) {
-    return false;
+template <size_t kBits>
+UInt<kBits>& UInt<kBits>::operator-=(const UInt& other) {
+  Word borrow = 0;
+  for (size_t i = 0; i < kWords; ++i) {
+    DoubleWord cur = static_cast<DoubleWord>(words_[i]) - other[i] - borrow;
+    words_[i] = static_cast<Word>(cur);
+    borrow = static_cast<Word>(cur >> (2 * kWordBits - 1));
   }
-  if (left.isNegative()) {
-    if (right.isNegative()) {
-      both_is_negative = true;
+  return *this;
+}
+
+template <size_t kBits>
+UInt<kBits>& UInt<kBits>::operator*=(const UInt& other) {
+  UInt ans;
+  for (size_t i = 0; i < kWords; ++i) {
+    Word carry = 0;
+    for (size_t j = 0; i + j < kWords; ++j) {
+      DoubleWord cur = static_cast<DoubleWord>(words_[i]) * other[j] +
+                       ans[i + j] + carry;
+      ans[i + j] = static_cast<Word>(cur);
+      carry = static_cast<Word>(cur >> kWordBits);
     }
-    return true;
-  }
-  if (right.isNegative()) {
-    return false;
   }
+  *this = ans;
+  return *this;
+}
 
-  if (left.getArr().size() != right.getArr().size()) {
-    return (left.getArr().size() < right.getArr().size()) ^ both_is_negative;
-  }
-  for (long long i = static_cast<long long>(left.getArr().size()) - 1; i >= 0;
-       --i) {
-    if (left.getArr()[i] != right.getArr()[i]) {
-      return (left.getArr()[i] < right.getArr()[i]) ^ both_is_negative;
+template <size_t kBits>
+int UInt<kBits>::compare(const UInt& left, const UInt& right) {
+  for (size_t i = kWords; i > 0; --i) {
+    if (left[i - 1] != right[i - 1]) {
+      return left[i - 1] < right[i - 1] ? -1 : 1;
     }
   }
-  return both_is_negative;
+  return 0;
 }
 
-bool operator!=(const BigInteger& left, const BigInteger& right) {
-  return !(left == right);
+template <size_t kBits>
+UInt<kBits> operator+(UInt<kBits> left, const UInt<kBits>& right) {
+  return left += right;
 }
 
-bool operator<=(const BigInteger& left, const BigInteger& right) {
-  return (left < right || left == right);
+template <size_t kBits>
+UInt<kBits> operator-(UInt<kBits> left, const UInt<kBits>& right) {
+  return left -= right;
 }
 
-bool operator>(const BigInteger& left, const BigInteger& right) {
-  return !(left <= right);
+template <size_t kBits>
+UInt<kBits> operator*(UInt<kBits> left, const UInt<kBits>& right) {
+  return left *= right;
 }
 
-bool operator>=(const BigInteger& left, const BigInteger& right) {
-  return !(left < right);
+template <size_t kBits>
+bool operator==(const UInt<kBits>& left, const UInt<kBits>& right) {
+  return UInt<kBits>::compare(left, right) == 0;
 }
 
-BigInteger operator""_bi(unsigned long long val) {
-  BigInteger value(val);
-  return value;
+template <size_t kBits>
+bool operator!=(const UInt<kBits>& left, const UInt<kBits>& right) {
+  return UInt<kBits>::compare(left, right) != 0;
 }
 
-BigInteger operator""_bi(const char* val, size_t size) {
-  BigInteger value(val);
-  ++size;
-  return value;
+template <size_t kBits>
+bool operator<(const UInt<kBits>& left, const UInt<kBits>& right) {
+  return UInt<kBits>::compare(left, right) < 0;
 }
 
-BigInteger BigInteger::operator+() const { return BigInteger(*this); }
-
-BigInteger BigInteger::operator-() const {
-  BigInteger tmp(*this);
-  tmp.is_negative_ = !tmp.is_negative_;
-  return tmp;
+template <size_t kBits>
+bool operator>(const UInt<kBits>& left, const UInt<kBits>& right) {
+  return UInt<kBits>::compare(left, right) > 0;
 }
 
-BigInteger operator+(const BigInteger& left, const BigInteger& right) {
-  BigInteger ans = left;
-  ans += right;
-  return ans;
+template <size_t kBits>
+bool operator<=(const UInt<kBits>& left, const UInt<kBits>& right) {
+  return UInt<kBits>::compare(left, right) <= 0;
 }
 
-BigInteger operator-(const BigInteger& left, const BigInteger& right) {
-  BigInteger ans = left;
-  ans -= right;
-  return ans;
+template <size_t kBits>
+bool operator>=(const UInt<kBits>& left, const UInt<kBits>& right) {
+  return UInt<kBits>::compare(left, right) >= 0;
 }
 
-BigInteger operator*(const BigInteger& left, const BigInteger& right) {
-  BigInteger ans = left;
-  ans *= right;
-  return ans;
-}
+template <size_t kBits>
+class UIntArray {
+ public:
+  using Word = typename UInt<kBits>::Word;
+  using DoubleWord = typename UInt<kBits>::DoubleWord;
+  static const size_t kWords = UInt<kBits>::kWords;
 
-BigInteger operator/(const BigInteger& left, const BigInteger& right) {
-  BigInteger ans = left;
-  ans /= right;
-  return ans;
-}
+  UIntArray() = default;
 
-BigInteger operator%(const BigInteger& left, const BigInteger& right) {
-  BigInteger ans = left;
-  ans %= right;
-  return ans;
-}
+  explicit UIntArray(size_t size) : size_(size), words_(kWords * size) {}
 
-BigInteger& BigInteger::operator++() { return (*this += 1); }
+  size_t size() const { return size_; }
 
-BigInteger BigInteger::operator++(int) {
-  *this += 1;
-  return *this - 1;
-}
+  UInt<kBits> get(size_t index) const;
 
-BigInteger& BigInteger::operator--() { return *this -= 1; }
+  void set(size_t index, const UInt<kBits>& value);
 
-BigInteger BigInteger::operator--(int) {
-  *this -= 1;
-  return *this + 1;
-}
+  Word* lane(size_t word) { return words_.data() + word * size_; }
 
-BigInteger& BigInteger::operator+=(const BigInteger& value) {
-  if (is_negative_) {
-    is_negative_ = false;
-    BigInteger tmp = abs(value);
-    value.is_negative_ ? * this += tmp : * this -= tmp;
-    is_negative_ = value.is_negative_ || tmp < *this;
-    return *this;
-  }
-  if (value.is_negative_) {
-    *this -= abs(value);
-    return *this;
-  }
-  int carry = 0;
-  for (size_t i = 0;
-       i < std::max(digits_.size(), value.digits_.size()) || carry != 0; ++i) {
-    if (i == digits_.size()) {
-      digits_.push_back(0);
-    }
-    digits_[i] += carry + (i < value.digits_.size() ? value.digits_[i] : 0);
-    carry = static_cast<int>(digits_[i] >= kBase);
-    if (carry != 0) {
-      digits_[i] -= kBase;
-    }
+  const Word* lane(size_t word) const { return words_.data() + word * size_; }
+
+  static void add(UIntArray& dst, const UIntArray& left,
+                  const UIntArray& right);
+
+  static void sub(UIntArray& dst, const UIntArray& left,
+                  const UIntArray& right);
+
+  static void mul(UIntArray& dst, const UIntArray& left,
+                  const UIntArray& right);
+
+  static void compare(std::vector<int>& dst, const UIntArray& left,
+                      const UIntArray& right);
+
+ private:
+  static const int kWordBits = UInt<kBits>::kWordBits;
+  static constexpr size_t kBlock = std::max<size_t>(4, 2048 / kWords);
+  size_t size_ = 0;
+  std::vector<Word> words_;
+
+  static void resizeLike(UIntArray& dst, const UIntArray& left,
+                         const UIntArray& right);
+};
+
+template <size_t kBits>
+UInt<kBits> UIntArray<kBits>::get(size_t index) const {
+  UInt<kBits> ans;
+  for (size_t i = 0; i < kWords; ++i) {
+    ans[i] = lane(i)[index];
   }
-  return *this;
+  return ans;
 }
 
-BigInteger& BigInteger::operator-=(const BigInteger& value) {
-  if (is_negative_) {
-    is_negative_ = false;
-    value.is_negative_ ? * this -= abs(value) : * this += abs(value);
-    is_negative_ = true;
-    return *this;
-  }
-  if (value.is_negative_) {
-    *this += abs(value);
-    return *this;
-  }
-  if (*this < value) {
-    BigInteger tmp = value;
-    swap(*this, tmp);
-    *this -= tmp;
-    is_negative_ = true;
-    return *this;
-  }
-  int carry = 0;
-  for (size_t i = 0; i < value.digits_.size() || carry != 0; ++i) {
-    digits_[i] -= carry + (i < value.digits_.size() ? value.digits_[i] : 0);
-    carry = static_cast<int>(digits_[i] < 0);
-    if (carry != 0) {
-      digits_[i] += kBase;
-    }
+template <size_t kBits>
+void UIntArray<kBits>::set(size_t index, const UInt<kBits>& value) {
+  for (size_t i = 0; i < kWords; ++i) {
+    lane(i)[index] = value[i];
   }
-  removeLeadZeros();
-  return *this;
 }
 
-BigInteger& BigInteger::operator*=(const BigInteger& value) {
-  BigInteger ans;
-  ans.digits_.resize(digits_.size() + value.digits_.size());
-  for (size_t i = 0; i < digits_.size(); ++i) {
-    int carry = 0;
-    for (size_t j = 0; j < value.digits_.size() || carry != 0; ++j) {
-      long long cur =
-              ans.digits_[i + j] +
-              digits_[i] * 1LL * (j < value.digits_.size() ? value.digits_[j] : 0) +
-              carry;
-      ans.digits_[i + j] = static_cast<int>(cur % kBase);
-      carry = static_cast<int>(cur / kBase);
-    }
+template <size_t kBits>
+void UIntArray<kBits>::resizeLike(UIntArray& dst, const UIntArray& left,
+                                  const UIntArray& right) {
+  if (left.size_ != right.size_) {
+    throw std::invalid_argument("Array sizes differ");
   }
-  ans.is_negative_ = is_negative_ != value.is_negative_;
-  ans.removeLeadZeros();
-  *this = ans;
-  return *this;
+  dst.size_ = left.size_;
+  dst.words_.resize(kWords * left.size_);
 }
 
-BigInteger& BigInteger::operator/=(const BigInteger& value) {
-  BigInteger tmp = abs(value);
-  BigInteger ans;
-  BigInteger current;
-  ans.digits_.resize(digits_.size());
-  for (long long i = static_cast<long long>(digits_.size()) - 1; i >= 0; --i) {
-    current.shiftRight();
-    current.digits_[0] = digits_[i];
-    current.removeLeadZeros();
-    int val = 0;
-    int left = 0;
-    int right = kBase;
-    while (left <= right) {
-      int medium = (left + right) / 2;
-      BigInteger gist = tmp * medium;
-      if (gist <= current) {
-        val = medium;
-        left = medium + 1;
-      } else {
-        right = medium - 1;
+template <size_t kBits>
+void UIntArray<kBits>::add(UIntArray& dst, const UIntArray& left,
+                           const UIntArray& right) {
+  resizeLike(dst, left, right);
+  for (size_t begin = 0; begin < dst.size_; begin += kBlock) {
+    size_t count = std::min(kBlock, dst.size_ - begin);
+    Word carry[kBlock] = {};
+    for (size_t i = 0; i < kWords; ++i) {
+      const Word* first = left.lane(i) + begin;
+      const Word* second = right.lane(i) + begin;
+      Word* out = dst.lane(i) + begin;
+      for (size_t j = 0; j < count; ++j) {
+        Word sum = first[j] + second[j];
+        Word cur = sum + carry[j];
+        carry[j] = static_cast<Word>(sum < first[j]) |
+                   static_cast<Word>(cur < sum);
+        out[j] = cur;
       }
     }
-    ans.digits_[i] = val;
-    current = current - tmp * val;
   }
-  ans.is_negative_ = is_negative_ != value.is_negative_;
-  ans.removeLeadZeros();
-  *this = ans;
-  return *this;
 }
 
-BigInteger& BigInteger::operator%=(const BigInteger& value) {
-  BigInteger bi1(*this);
-  bi1 /= value;
-  bi1 *= value;
-  *this -= bi1;
-  return *this;
+template <size_t kBits>
+void UIntArray<kBits>::sub(UIntArray& dst, const UIntArray& left,
+                           const UIntArray& right) {
+  resizeLike(dst, left, right);
+  for (size_t begin = 0; begin < dst.size_; begin += kBlock) {
+    size_t count = std::min(kBlock, dst.size_ - begin);
+    Word borrow[kBlock] = {};
+    for (size_t i = 0; i < kWords; ++i) {
+      const Word* first = left.lane(i) + begin;
+      const Word* second = right.lane(i) + begin;
+      Word* out = dst.lane(i) + begin;
+      for (size_t j = 0; j < count; ++j) {
+        Word diff = first[j] - second[j];
+        Word cur = diff - borrow[j];
+        borrow[j] = static_cast<Word>(first[j] < second[j]) |
+                    static_cast<Word>(diff < borrow[j]);
+        out[j] = cur;
+      }
+    }
+  }
 }
 
-BigInteger BigInteger::gcd(BigInteger left, BigInteger right) {
-  left.is_negative_ = false;
-  right.is_negative_ = false;
-  while (right != 0) {
-    left %= right;
-    swap(left, right);
+template <size_t kBits>
+void UIntArray<kBits>::mul(UIntArray& dst, const UIntArray& left,
+                           const UIntArray& right) {
+  resizeLike(dst, left, right);
+  for (size_t begin = 0; begin < dst.size_; begin += kBlock) {
+    size_t count = std::min(kBlock, dst.size_ - begin);
+    Word product[kWords][kBlock] = {};
+    for (size_t i = 0; i < kWords; ++i) {
+      const Word* first = left.lane(i) + begin;
+      Word carry[kBlock] = {};
+      for (size_t j = 0; i + j < kWords; ++j) {
+        const Word* second = right.lane(j) + begin;
+        Word* out = product[i + j];
+        for (size_t k = 0; k < count; ++k) {
+          DoubleWord cur = static_cast<DoubleWord>(first[k]) * second[k] +
+                           out[k] + carry[k];
+          out[k] = static_cast<Word>(cur);
+          carry[k] = static_cast<Word>(cur >> kWordBits);
+        }
+      }
+    }
+    for (size_t i = 0; i < kWords; ++i) {
+      std::copy(product[i], product[i] + count, dst.lane(i) + begin);
+    }
   }
-  return left;
 }
 
-BigInteger BigInteger::abs(const BigInteger& value) {
-  BigInteger tmp = value;
-  tmp.is_negative_ = false;
-  return tmp;
+template <size_t kBits>
+void UIntArray<kBits>::compare(std::vector<int>& dst, const UIntArray& left,
+                               const UIntArray& right) {
+  if (left.size_ != right.size_) {
+    throw std::invalid_argument("Array sizes differ");
+  }
+  size_t size = left.size_;
+  dst.assign(size, 0);
+  for (size_t i = kWords; i > 0; --i) {
+    const Word* first = left.lane(i - 1);
+    const Word* second = right.lane(i - 1);
+    for (size_t j = 0; j < size; ++j) {
+      int cur = static_cast<int>(first[j] > second[j]) -
+                static_cast<int>(first[j] < second[j]);
+      dst[j] = dst[j] != 0 ? dst[j] : cur;
+    }
+  }
 }
 
 class Rational {
  public:
-  Rational() = default;
+  Rational() : denominator_(1) {}
 
   Rational(const Rational& other) = default;
 
@@ -466,18 +3092,34 @@ class Rational {
 
   Rational operator-() const;
 
-  BigInteger getNominator() const { return nominator_; }
+  BigInteger getNominator() const {
+    return normalized_ ? nominator_ : reduced().nominator_;
+  }
+
+  BigInteger getDenominator() const {
+    return normalized_ ? denominator_ : reduced().denominator_;
+  }
+
+  void normalize();
+
+  // Off by default. When on, sums and products keep the gcd in place until
+  // normalize() is called or the value grows past kNormalizeLimit, and the
+  // const observers reduce a copy on every call.
+  static void setLazyNormalization(bool lazy);
 
-  BigInteger getDenominator() const { return denominator_; }
+  static bool lazyNormalization();
+
+  static int compare(const Rational& left, const Rational& right);
 
   bool isNegative() const { return is_negative_; }
 
   std::string toString() const;
 
-  std::string asDecimal(size_t precision);
+  std::string asDecimal(size_t precision) const;
 
-  explicit operator double() {
-    return std::stod((*this).asDecimal(Rational::kDecimal));
+  explicit operator double() const {
+    return BigInteger::ratioToDouble(is_negative_ ? -nominator_ : nominator_,
+                                     denominator_);
   }
 
   void checkNull() {
@@ -491,47 +3133,48 @@ class Rational {
  private:
   BigInteger nominator_, denominator_;
   bool is_negative_ = false;
-  const int kDecimal = 300;
-  const int kNum = 10;
+  bool normalized_ = true;
+  size_t normalized_size_ = 1;
+  static const size_t kNormalizeLimit = 16;
+  static constexpr double kLogError = 1e-8;
+  static constexpr double kLogRelativeError = 1e-14;
+
+  static std::atomic<bool>& lazy();
 
   static void swap(Rational& left, Rational& right);
 
-  void rationalOperatorsGcd(Rational& tmp, const Rational& other, int sig);
+  Rational reduced() const;
 
-  static void rationalGcd(Rational& tmp);
+  void addSigned(const Rational& other, bool negative);
+
+  void multiply(const BigInteger& nominator, const BigInteger& denominator,
+                bool normalized);
+
+  void normalizeIfNeeded();
 };
 
 bool operator==(const Rational& left, const Rational& right) {
-  return left.isNegative() == right.isNegative() and
-         BigInteger::abs(left.getNominator()) ==
-         BigInteger::abs(right.getNominator()) and
-         BigInteger::abs(left.getDenominator()) ==
-         BigInteger::abs(right.getDenominator());
+  return Rational::compare(left, right) == 0;
 }
 
 bool operator!=(const Rational& left, const Rational& right) {
-  return !(left == right);
+  return Rational::compare(left, right) != 0;
 }
 
 bool operator<(const Rational& left, const Rational& right) {
-  if (left.isNegative() ^ right.isNegative()) {
-    return static_cast<int>(left.isNegative()) >
-           static_cast<int>(right.isNegative());
-  }
-  return right.getNominator() * left.getDenominator() >
-         left.getNominator() * right.getDenominator();
+  return Rational::compare(left, right) < 0;
 }
 
 bool operator>(const Rational& left, const Rational& right) {
-  return !(left < right) and (left != right);
+  return Rational::compare(left, right) > 0;
 }
 
 bool operator<=(const Rational& left, const Rational& right) {
-  return !(left > right);
+  return Rational::compare(left, right) <= 0;
 }
 
 bool operator>=(const Rational& left, const Rational& right) {
-  return !(left < right);
+  return Rational::compare(left, right) >= 0;
 }
 
 Rational operator+(const Rational& left, const Rational& right) {
@@ -562,10 +3205,13 @@ Rational operator*(const Rational& left, const Rational& right) {
   return tmp;
 }
 
-Rational::Rational(const BigInteger& bi1, const BigInteger& bi2) {
-  nominator_ /= BigInteger::gcd(bi1, bi2);
-  denominator_ /= BigInteger::gcd(bi1, bi2);
-  is_negative_ = bi1.isNegative() ^ bi2.isNegative();
+Rational::Rational(const BigInteger& bi1, const BigInteger& bi2)
+        : nominator_(BigInteger::abs(bi1)),
+          denominator_(BigInteger::abs(bi2)),
+          is_negative_(bi1.isNegative() ^ bi2.isNegative()),
+          normalized_(false) {
+  checkNull();
+  normalizeIfNeeded();
 }
 
 Rational& Rational::operator=(int other) {
@@ -589,77 +3235,157 @@ Rational& Rational::operator=(const Rational& other) {
   return *this;
 }
 
-void Rational::rationalGcd(Rational& tmp) {
-  BigInteger gcd = BigInteger::gcd(tmp.nominator_, tmp.denominator_);
-  tmp.nominator_ /= gcd;
-  tmp.denominator_ /= gcd;
+int Rational::compare(const Rational& left, const Rational& right) {
+  if (left.is_negative_ != right.is_negative_) {
+    return left.is_negative_ ? -1 : 1;
+  }
+  int sign = left.is_negative_ ? -1 : 1;
+  bool left_zero = left.nominator_ == 0;
+  bool right_zero = right.nominator_ == 0;
+  if (left_zero || right_zero) {
+    return sign *
+           (static_cast<int>(!left_zero) - static_cast<int>(!right_zero));
+  }
+  if (left.denominator_ == right.denominator_) {
+    if (left.nominator_ == right.nominator_) {
+      return 0;
+    }
+    return sign * (left.nominator_ < right.nominator_ ? -1 : 1);
+  }
+  size_t left_size = left.nominator_.getArr().size() +
+                     right.denominator_.getArr().size();
+  size_t right_size = right.nominator_.getArr().size() +
+                      left.denominator_.getArr().size();
+  if (left_size + 1 < right_size) {
+    return -sign;
+  }
+  if (right_size + 1 < left_size) {
+    return sign;
+  }
+  double first = left.nominator_.logAbs() + right.denominator_.logAbs();
+  double second = right.nominator_.logAbs() + left.denominator_.logAbs();
+  double error = kLogError +
+                 kLogRelativeError * (std::abs(first) + std::abs(second));
+  if (first + error < second) {
+    return -sign;
+  }
+  if (second + error < first) {
+    return sign;
+  }
+  BigInteger left_product;
+  BigInteger right_product;
+  BigInteger::mul(left_product, left.nominator_, right.denominator_);
+  BigInteger::mul(right_product, right.nominator_, left.denominator_);
+  if (left_product == right_product) {
+    return 0;
+  }
+  return sign * (left_product < right_product ? -1 : 1);
+}
+
+void Rational::normalize() {
+  if (normalized_) {
+    return;
+  }
+  BigInteger gcd = BigInteger::gcd(nominator_, denominator_);
+  if (gcd != 1) {
+    nominator_ /= gcd;
+    denominator_ /= gcd;
+  }
+  normalized_ = true;
+  normalized_size_ = std::max(nominator_.getArr().size(),
+                              denominator_.getArr().size());
+}
+
+void Rational::setLazyNormalization(bool lazy) { Rational::lazy() = lazy; }
+
+bool Rational::lazyNormalization() { return lazy(); }
+
+std::atomic<bool>& Rational::lazy() {
+  static std::atomic<bool> lazy{false};
+  return lazy;
 }
 
-void Rational::rationalOperatorsGcd(Rational& tmp, const Rational& other,
-                                    int sig) {
-  if (sig == 1 or sig == -1) {
-    tmp.denominator_ = denominator_ * other.denominator_;
-    tmp.nominator_ =
-            nominator_ * other.denominator_ + sig * denominator_ * other.nominator_;
-    rationalGcd(tmp);
-  } else {
-    is_negative_ = is_negative_ ^ other.is_negative_;
-    if (sig == 0) {
-      denominator_ = denominator_ * other.denominator_;
-      nominator_ = nominator_ * other.nominator_;
-    } else {
-      denominator_ = denominator_ * other.nominator_;
-      nominator_ = nominator_ * other.denominator_;
-    }
-    rationalGcd(*this);
+Rational Rational::reduced() const {
+  Rational ans(*this);
+  ans.normalize();
+  return ans;
+}
+
+void Rational::normalizeIfNeeded() {
+  size_t size = std::max(nominator_.getArr().size(),
+                         denominator_.getArr().size());
+  if (!lazy() || size > 2 * normalized_size_ + kNormalizeLimit) {
+    normalize();
   }
 }
 
-Rational& Rational::operator+=(const Rational& other) {
-  Rational tmp;
-  if ((is_negative_ ^ other.is_negative_) == 0) {
-    tmp.is_negative_ = ((static_cast<int>(is_negative_) &
-                         static_cast<int>(other.is_negative_)) != 0);
-    rationalOperatorsGcd(tmp, other, 1);
-    *this = tmp;
-    checkNull();
-    return *this;
-  }
-  if (is_negative_ or other.is_negative_) {
-    tmp = is_negative_ ? *this : other;
-    tmp.is_negative_ = is_negative_ ? !is_negative_ : !other.is_negative_;
-    *this = is_negative_ ? other - tmp : *this - tmp;
-    tmp.is_negative_ = false;
-    is_negative_ = is_negative_ ? other < tmp : *this < tmp;
+void Rational::addSigned(const Rational& other, bool negative) {
+  BigInteger left_product;
+  BigInteger right_product;
+  const BigInteger* left = &nominator_;
+  const BigInteger* right = &other.nominator_;
+  if (denominator_ != other.denominator_) {
+    BigInteger::mul(left_product, nominator_, other.denominator_);
+    BigInteger::mul(right_product, other.nominator_, denominator_);
+    left = &left_product;
+    right = &right_product;
+    denominator_ *= other.denominator_;
+  }
+  if (is_negative_ == negative) {
+    BigInteger::add(nominator_, *left, *right);
+  } else if (*left < *right) {
+    BigInteger::sub(nominator_, *right, *left);
+    is_negative_ = negative;
+  } else {
+    BigInteger::sub(nominator_, *left, *right);
   }
+  normalized_ = false;
   checkNull();
+  normalizeIfNeeded();
+}
+
+void Rational::multiply(const BigInteger& nominator,
+                        const BigInteger& denominator, bool normalized) {
+  BigInteger first = 1;
+  if (denominator != 1 && nominator_ != 1) {
+    first = BigInteger::gcd(nominator_, denominator);
+  }
+  BigInteger second = 1;
+  if (nominator != 1 && denominator_ != 1) {
+    second = BigInteger::gcd(nominator, denominator_);
+  }
+  BigInteger next_nominator = nominator_ / first;
+  next_nominator *= nominator / second;
+  BigInteger next_denominator = denominator_ / second;
+  next_denominator *= denominator / first;
+  BigInteger::swap(nominator_, next_nominator);
+  BigInteger::swap(denominator_, next_denominator);
+  normalized_ = normalized_ && normalized;
+  normalizeIfNeeded();
+}
+
+Rational& Rational::operator+=(const Rational& other) {
+  addSigned(other, other.is_negative_);
   return *this;
 }
 
 Rational& Rational::operator-=(const Rational& other) {
-  Rational tmp;
-  if ((is_negative_ ^ other.is_negative_) == 0) {
-    tmp.is_negative_ = *this < other;
-    rationalOperatorsGcd(tmp, other, -1);
-    *this = tmp;
-    checkNull();
-    return *this;
-  }
-  tmp = other;
-  tmp.is_negative_ = !other.is_negative_;
-  *this += tmp;
-  checkNull();
+  addSigned(other, !other.is_negative_);
   return *this;
 }
 
 Rational& Rational::operator*=(const Rational& other) {
-  rationalOperatorsGcd(*this, other, 0);
+  bool negative = is_negative_ ^ other.is_negative_;
+  multiply(other.nominator_, other.denominator_, other.normalized_);
+  is_negative_ = negative;
   checkNull();
   return *this;
 }
 
 Rational& Rational::operator/=(const Rational& other) {
-  rationalOperatorsGcd(*this, other, 2);
+  bool negative = is_negative_ ^ other.is_negative_;
+  multiply(other.denominator_, other.nominator_, other.normalized_);
+  is_negative_ = negative;
   checkNull();
   return *this;
 }
@@ -673,6 +3399,9 @@ Rational Rational::operator-() const {
 }
 
 std::string Rational::toString() const {
+  if (!normalized_) {
+    return reduced().toString();
+  }
   std::string ans;
   ans = is_negative_ ? "-" : "";
   ans += nominator_.toString();
@@ -680,20 +3409,18 @@ std::string Rational::toString() const {
   return ans;
 }
 
-std::string Rational::asDecimal(size_t precision) {
-  Rational tmp = *this;
-  tmp.setSign(true);
-  std::string ans;
-  ans += isNegative() ? "-" : "";
-  ans += (tmp.nominator_ / tmp.denominator_).toString();
-  tmp.nominator_ %= tmp.denominator_;
-  ans += precision != 0 ? "." : "";
-  std::string element;
-  for (size_t i = 0; i < precision; ++i) {
-    tmp.nominator_ *= kNum;
-    element = (tmp.nominator_ / tmp.denominator_).toString();
-    ans += element;
-    tmp.nominator_ %= tmp.denominator_;
+std::string Rational::asDecimal(size_t precision) const {
+  BigInteger scaled = nominator_ * BigInteger::pow(10, precision);
+  scaled /= denominator_;
+  std::string digits = scaled.toString();
+  if (digits.size() <= precision) {
+    digits.insert(0, precision + 1 - digits.size(), '0');
+  }
+  std::string ans = is_negative_ ? "-" : "";
+  ans += digits.substr(0, digits.size() - precision);
+  if (precision != 0) {
+    ans += '.';
+    ans += digits.substr(digits.size() - precision);
   }
   return ans;
 }
@@ -702,4 +3429,6 @@ void Rational::swap(Rational& left, Rational& right) {
   BigInteger::swap(left.nominator_, right.nominator_);
   BigInteger::swap(left.denominator_, right.denominator_);
   std::swap(left.is_negative_, right.is_negative_);
+  std::swap(left.normalized_, right.normalized_);
+  std::swap(left.normalized_size_, right.normalized_size_);
 }
\ No newline at end of file
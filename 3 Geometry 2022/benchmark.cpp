@@ -0,0 +1,266 @@
+#include <algorithm>
+#include <iostream>
+#include <memory>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "../benchmark.h"
+#include "geometry.h"
+
+class Generator {
+ public:
+  explicit Generator(unsigned long long seed) : engine_(seed) {}
+
+  std::vector<Point> star(size_t count);
+
+  static std::vector<Point> regular(size_t count);
+
+  std::vector<Point> cloud(size_t count, double extent);
+
+  std::vector<Point> circle(size_t count);
+
+ private:
+  std::mt19937_64 engine_;
+};
+
+std::vector<Point> Generator::star(size_t count) {
+  std::uniform_real_distribution<double> radius(0.5, 1.5);
+  std::vector<Point> vertices;
+  vertices.reserve(count);
+  for (size_t i = 0; i < count; ++i) {
+    double angle = 2 * M_PI * static_cast<double>(i) / count;
+    double len = radius(engine_);
+    vertices.emplace_back(len * cos(angle), len * sin(angle));
+  }
+  return vertices;
+}
+
+std::vector<Point> Generator::regular(size_t count) {
+  std::vector<Point> vertices;
+  vertices.reserve(count);
+  for (size_t i = 0; i < count; ++i) {
+    double angle = 2 * M_PI * static_cast<double>(i) / count;
+    vertices.emplace_back(cos(angle), sin(angle));
+  }
+  return vertices;
+}
+
+std::vector<Point> Generator::cloud(size_t count, double extent) {
+  std::uniform_real_distribution<double> coordinate(-extent, extent);
+  std::vector<Point> points;
+  points.reserve(count);
+  for (size_t i = 0; i < count; ++i) {
+    double x = coordinate(engine_);
+    points.emplace_back(x, coordinate(engine_));
+  }
+  return points;
+}
+
+std::vector<Point> Generator::circle(size_t count) {
+  std::uniform_real_distribution<double> angle(0, 2 * M_PI);
+  std::vector<Point> points;
+  points.reserve(count);
+  for (size_t i = 0; i < count; ++i) {
+    double alpha = angle(engine_);
+    points.emplace_back(cos(alpha), sin(alpha));
+  }
+  return points;
+}
+
+void PolygonBenchmarks(BenchmarkSuite& suite) {
+  for (size_t size : Sizes(10, suite.limit("max-vertices"))) {
+    Generator generator(size);
+    std::vector<Point> vertices = generator.star(size);
+    if (suite.selected("polygon_copy")) {
+      suite.run("polygon_copy", size, [&]() {
+        Polygon polygon(vertices);
+        return static_cast<double>(polygon.verticesCount());
+      });
+    }
+    if (suite.selected("polygon_area")) {
+      suite.run("polygon_area", size, [&]() {
+        Polygon polygon(vertices);
+        return polygon.area();
+      });
+    }
+    if (suite.selected("polygon_perimeter")) {
+      suite.run("polygon_perimeter", size, [&]() {
+        Polygon polygon(vertices);
+        return polygon.perimeter();
+      });
+    }
+    if (suite.selected("polygon_centroid")) {
+      suite.run("polygon_centroid", size, [&]() {
+        Polygon polygon(vertices);
+        return polygon.centroid().x;
+      });
+    }
+    if (suite.selected("polygon_transform")) {
+      Polygon polygon(vertices);
+      suite.run("polygon_transform", size, [&]() {
+        polygon.rotate(Point(0, 0), 30);
+        polygon.scale(Point(1, 1), 1.5);
+        polygon.reflect(Line(2, 1));
+        polygon.scale(Point(1, 1), 1 / 1.5);
+        return polygon.boundingBox().max.x;
+      });
+    }
+    if (suite.selected("polygon_cached")) {
+      Polygon polygon(vertices);
+      suite.run("polygon_cached", size, [&]() {
+        return polygon.area() + polygon.perimeter() + polygon.centroid().x;
+      });
+    }
+  }
+}
+
+void ContainmentBenchmarks(BenchmarkSuite& suite) {
+  const size_t kPoints = 100000;
+  size_t max_vertices = std::min<size_t>(10000, suite.limit("max-vertices"));
+  for (size_t size : Sizes(10, max_vertices)) {
+    Generator generator(size);
+    Polygon polygon(generator.star(size));
+    std::vector<Point> points = generator.cloud(kPoints, 1.5);
+    if (suite.selected("contains_point")) {
+      suite.run("contains_point", size, [&]() {
+        size_t inside = 0;
+        for (Point point : points) {
+          inside += static_cast<size_t>(polygon.containsPoint(point));
+        }
+        return static_cast<double>(inside);
+      });
+    }
+    if (suite.selected("contains_points")) {
+      suite.run("contains_points", size, [&]() {
+        std::vector<bool> inside = polygon.containsPoints(points);
+        return static_cast<double>(
+                std::count(inside.begin(), inside.end(), true));
+      });
+    }
+    Polygon convex(Generator::regular(size));
+    if (suite.selected("contains_point_convex")) {
+      suite.run("contains_point_convex", size, [&]() {
+        size_t inside = 0;
+        for (Point point : points) {
+          inside += static_cast<size_t>(convex.containsPoint(point));
+        }
+        return static_cast<double>(inside);
+      });
+    }
+  }
+}
+
+void HullBenchmarks(BenchmarkSuite& suite) {
+  for (size_t size : Sizes(10, suite.limit("max-points"))) {
+    Generator generator(size);
+    if (suite.selected("hull_uniform")) {
+      std::vector<Point> points = generator.cloud(size, 1);
+      suite.run("hull_uniform", size, [&]() {
+        return static_cast<double>(ConvexHull(points).verticesCount());
+      });
+    }
+    if (suite.selected("hull_circle")) {
+      std::vector<Point> points = generator.circle(size);
+      suite.run("hull_circle", size, [&]() {
+        return static_cast<double>(ConvexHull(points).verticesCount());
+      });
+    }
+  }
+}
+
+std::vector<std::unique_ptr<Shape>> Scene(Generator& generator, size_t count) {
+  const double kExtent = 1000;
+  std::vector<Point> centers = generator.cloud(count, kExtent);
+  std::vector<std::unique_ptr<Shape>> shapes;
+  for (size_t i = 0; i < count; ++i) {
+    if (i % 2 == 0) {
+      shapes.emplace_back(new Circle(centers[i], 5));
+    } else {
+      std::vector<Point> vertices = generator.star(8);
+      for (auto& vertex : vertices) {
+        vertex = Point(centers[i].x + 5 * vertex.x,
+                       centers[i].y + 5 * vertex.y);
+      }
+      shapes.emplace_back(new Polygon(vertices));
+    }
+  }
+  return shapes;
+}
+
+void IndexBenchmarks(BenchmarkSuite& suite) {
+  const size_t kQueries = 1000;
+  for (size_t size : {1000, 10000, 100000}) {
+    Generator generator(size);
+    std::vector<std::unique_ptr<Shape>> owned = Scene(generator, size);
+    std::vector<Shape*> shapes;
+    for (const auto& shape : owned) {
+      shapes.push_back(shape.get());
+    }
+    std::vector<Point> queries = generator.cloud(kQueries, 1000);
+    if (suite.selected("index_scan")) {
+      suite.run("index_scan", size, [&]() {
+        size_t found = 0;
+        for (Point query : queries) {
+          for (Shape* shape : shapes) {
+            found += static_cast<size_t>(shape->containsPoint(query));
+          }
+        }
+        return static_cast<double>(found);
+      });
+    }
+    for (auto layout :
+         {ShapeIndex::Layout::kRTree, ShapeIndex::Layout::kGrid}) {
+      std::string name = layout == ShapeIndex::Layout::kRTree ? "index_rtree"
+                                                              : "index_grid";
+      if (suite.selected(name + "_build")) {
+        suite.run(name + "_build", size, [&]() {
+          return static_cast<double>(ShapeIndex(shapes, layout).size());
+        });
+      }
+      ShapeIndex index(shapes, layout);
+      if (suite.selected(name + "_contains")) {
+        suite.run(name + "_contains", size, [&]() {
+          size_t found = 0;
+          for (Point query : queries) {
+            found += index.containing(query).size();
+          }
+          return static_cast<double>(found);
+        });
+      }
+      if (suite.selected(name + "_nearest")) {
+        suite.run(name + "_nearest", size, [&]() {
+          double sum = 0;
+          for (Point query : queries) {
+            sum += index.nearest(query)->boundingBox().min.x;
+          }
+          return sum;
+        });
+      }
+      if (suite.selected(name + "_update")) {
+        suite.run(name + "_update", size, [&]() {
+          shapes[0]->reflect(Point(0, 0));
+          return static_cast<double>(index.containing(queries[0]).size());
+        });
+      }
+    }
+  }
+}
+
+int main(int argc, char** argv) {
+  Options options;
+  try {
+    options = ParseOptions(argc, argv, {{"max-vertices", 1000000},
+                                        {"max-points", 10000000}});
+  } catch (const std::exception& error) {
+    std::cerr << error.what() << "\n";
+    return 1;
+  }
+  Polygon::setThreadCount(options.threads);
+  BenchmarkSuite suite(options);
+  PolygonBenchmarks(suite);
+  ContainmentBenchmarks(suite);
+  IndexBenchmarks(suite);
+  HullBenchmarks(suite);
+  suite.print(std::cout);
+}
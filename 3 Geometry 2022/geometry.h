@@ -3,11 +3,20 @@
 #include <math.h>
 
 #include <algorithm>
+#include <atomic>
 #include <fstream>
+#include <functional>
 #include <iomanip>
 #include <iostream>
+#include <limits>
+#include <mutex>
+#include <new>
+#include <numeric>
+#include <queue>
 #include <sstream>
 #include <string>
+#include <system_error>
+#include <thread>
 #include <type_traits>
 #include <vector>
 
@@ -16,6 +25,15 @@ const double kPid = 180.0;
 const long long kConst = 1000000000000;
 const int kTrvert = 3;
 const double kEps = 0.000001;
+const size_t kLanes = 16;
+const double kRoundoff = std::numeric_limits<double>::epsilon() / 2;
+const double kResultBound = (3 + 8 * kRoundoff) * kRoundoff;
+const double kOrientationBound = (3 + 16 * kRoundoff) * kRoundoff;
+const double kOrientationBoundB = (2 + 12 * kRoundoff) * kRoundoff;
+const double kOrientationBoundC = (9 + 64 * kRoundoff) * kRoundoff * kRoundoff;
+const double kInCircleBound = (10 + 96 * kRoundoff) * kRoundoff;
+const size_t kHullFilter = 64;
+const size_t kParallelHull = 1 << 16;
 
 struct Point {
   double x;  //  NOLINT
@@ -49,6 +67,265 @@ std::ostream& operator<<(std::ostream& ostream, const Point& point) {
   return ostream;
 }
 
+void TwoSum(double left, double right, double& sum, double& error) {
+  sum = left + right;
+  double right_part = sum - left;
+  double left_part = sum - right_part;
+  error = (left - left_part) + (right - right_part);
+}
+
+void TwoDiff(double left, double right, double& diff, double& error) {
+  TwoSum(left, -right, diff, error);
+}
+
+void TwoProduct(double left, double right, double& product, double& error) {
+  product = left * right;
+  error = fma(left, right, -product);
+}
+
+size_t GrowExpansion(const double* expansion, size_t length, double term,
+                     double* result) {
+  size_t count = 0;
+  for (size_t i = 0; i < length; ++i) {
+    double error;
+    TwoSum(term, expansion[i], term, error);
+    if (error != 0) {
+      result[count++] = error;
+    }
+  }
+  if (term != 0 || count == 0) {
+    result[count++] = term;
+  }
+  return count;
+}
+
+size_t ExpansionSum(const double* first, size_t first_length,
+                    const double* second, size_t second_length,
+                    double* result) {
+  std::copy(first, first + first_length, result);
+  size_t length = first_length;
+  for (size_t i = 0; i < second_length; ++i) {
+    length = GrowExpansion(result, length, second[i], result);
+  }
+  return length;
+}
+
+size_t ScaleExpansion(const double* expansion, size_t length, double scale,
+                      double* result) {
+  size_t count = 0;
+  double carry;
+  double error;
+  TwoProduct(expansion[0], scale, carry, error);
+  if (error != 0) {
+    result[count++] = error;
+  }
+  for (size_t i = 1; i < length; ++i) {
+    double product;
+    double product_error;
+    TwoProduct(expansion[i], scale, product, product_error);
+    TwoSum(carry, product_error, carry, error);
+    if (error != 0) {
+      result[count++] = error;
+    }
+    TwoSum(product, carry, carry, error);
+    if (error != 0) {
+      result[count++] = error;
+    }
+  }
+  if (carry != 0 || count == 0) {
+    result[count++] = carry;
+  }
+  return count;
+}
+
+std::vector<double> ExpansionProduct(const std::vector<double>& first,
+                                     const std::vector<double>& second) {
+  std::vector<double> result(1, 0.0);
+  std::vector<double> scaled(2 * first.size());
+  std::vector<double> sum;
+  for (double scale : second) {
+    size_t length = ScaleExpansion(first.data(), first.size(), scale,
+                                   scaled.data());
+    sum.resize(result.size() + length);
+    sum.resize(ExpansionSum(result.data(), result.size(), scaled.data(),
+                            length, sum.data()));
+    result.swap(sum);
+  }
+  return result;
+}
+
+std::vector<double> ExpansionAdd(const std::vector<double>& first,
+                                 const std::vector<double>& second) {
+  std::vector<double> result(first.size() + second.size());
+  result.resize(ExpansionSum(first.data(), first.size(), second.data(),
+                             second.size(), result.data()));
+  return result;
+}
+
+std::vector<double> ExpansionDiff(const std::vector<double>& first,
+                                  std::vector<double> second) {
+  for (double& term : second) {
+    term = -term;
+  }
+  return ExpansionAdd(first, second);
+}
+
+size_t ProductDiff(double a, double b, double c, double d, double* result) {
+  double left[2];
+  double right[2];
+  TwoProduct(a, b, left[1], left[0]);
+  TwoProduct(-c, d, right[1], right[0]);
+  return ExpansionSum(left, 2, right, 2, result);
+}
+
+int Sign(double value) { return (value > 0) - (value < 0); }
+
+double OrientedAreaAdapt(Point origin, Point first, Point second,
+                         double magnitude) {
+  double fx = first.x - origin.x;
+  double fy = first.y - origin.y;
+  double sx = second.x - origin.x;
+  double sy = second.y - origin.y;
+  double estimate[4];
+  size_t length = ProductDiff(fx, sy, fy, sx, estimate);
+  double det = std::accumulate(estimate, estimate + length, 0.0);
+  if (std::abs(det) >= kOrientationBoundB * magnitude) {
+    return det;
+  }
+  double fx_tail;
+  double fy_tail;
+  double sx_tail;
+  double sy_tail;
+  TwoDiff(first.x, origin.x, fx, fx_tail);
+  TwoDiff(first.y, origin.y, fy, fy_tail);
+  TwoDiff(second.x, origin.x, sx, sx_tail);
+  TwoDiff(second.y, origin.y, sy, sy_tail);
+  if (fx_tail == 0 && fy_tail == 0 && sx_tail == 0 && sy_tail == 0) {
+    return det;
+  }
+  double bound = kOrientationBoundC * magnitude + kResultBound * std::abs(det);
+  det += (fx * sy_tail + sy * fx_tail) - (fy * sx_tail + sx * fy_tail);
+  if (std::abs(det) >= bound) {
+    return det;
+  }
+  double correction[4];
+  double first_sum[8];
+  double second_sum[12];
+  double exact[16];
+  size_t correction_length = ProductDiff(fx_tail, sy, fy_tail, sx, correction);
+  size_t first_length = ExpansionSum(estimate, length, correction,
+                                     correction_length, first_sum);
+  correction_length = ProductDiff(fx, sy_tail, fy, sx_tail, correction);
+  size_t second_length = ExpansionSum(first_sum, first_length, correction,
+                                      correction_length, second_sum);
+  correction_length = ProductDiff(fx_tail, sy_tail, fy_tail, sx_tail,
+                                  correction);
+  size_t exact_length = ExpansionSum(second_sum, second_length, correction,
+                                     correction_length, exact);
+  return exact[exact_length - 1];
+}
+
+double OrientedArea(Point origin, Point first, Point second) {
+  double left = (first.x - origin.x) * (second.y - origin.y);
+  double right = (first.y - origin.y) * (second.x - origin.x);
+  double det = left - right;
+  double magnitude = std::abs(left) + std::abs(right);
+  if (std::abs(det) >= kOrientationBound * magnitude) {
+    return det;
+  }
+  return OrientedAreaAdapt(origin, first, second, magnitude);
+}
+
+int Orientation(Point origin, Point first, Point second) {
+  double left = (first.x - origin.x) * (second.y - origin.y);
+  double right = (first.y - origin.y) * (second.x - origin.x);
+  double det = left - right;
+  double magnitude = std::abs(left) + std::abs(right);
+  double bound = kOrientationBound * magnitude;
+  if (det > bound) {
+    return 1;
+  }
+  if (det < -bound) {
+    return -1;
+  }
+  return Sign(OrientedAreaAdapt(origin, first, second, magnitude));
+}
+
+int CrossOrientation(Point first_from, Point first_to, Point second_from,
+                     Point second_to) {
+  double first_x[2];
+  double first_y[2];
+  double second_x[2];
+  double second_y[2];
+  TwoDiff(first_to.x, first_from.x, first_x[1], first_x[0]);
+  TwoDiff(first_to.y, first_from.y, first_y[1], first_y[0]);
+  TwoDiff(second_to.x, second_from.x, second_x[1], second_x[0]);
+  TwoDiff(second_to.y, second_from.y, second_y[1], second_y[0]);
+  std::vector<double> left = ExpansionProduct({first_x[0], first_x[1]},
+                                              {second_y[0], second_y[1]});
+  std::vector<double> right = ExpansionProduct({first_y[0], first_y[1]},
+                                               {second_x[0], second_x[1]});
+  return Sign(ExpansionDiff(left, right).back());
+}
+
+std::vector<double> ExactDiff(double left, double right) {
+  double diff;
+  double error;
+  TwoDiff(left, right, diff, error);
+  if (error == 0) {
+    return {diff};
+  }
+  return {error, diff};
+}
+
+int InCircleExact(Point first, Point second, Point third, Point point) {
+  std::vector<double> xs[3] = {ExactDiff(first.x, point.x),
+                               ExactDiff(second.x, point.x),
+                               ExactDiff(third.x, point.x)};
+  std::vector<double> ys[3] = {ExactDiff(first.y, point.y),
+                               ExactDiff(second.y, point.y),
+                               ExactDiff(third.y, point.y)};
+  std::vector<double> det(1, 0.0);
+  for (size_t i = 0; i < 3; ++i) {
+    size_t next = (i + 1) % 3;
+    size_t last = (i + 2) % 3;
+    std::vector<double> lift = ExpansionAdd(ExpansionProduct(xs[i], xs[i]),
+                                            ExpansionProduct(ys[i], ys[i]));
+    std::vector<double> minor =
+            ExpansionDiff(ExpansionProduct(xs[next], ys[last]),
+                          ExpansionProduct(xs[last], ys[next]));
+    det = ExpansionAdd(det, ExpansionProduct(lift, minor));
+  }
+  return Sign(det.back());
+}
+
+int InCircle(Point first, Point second, Point third, Point point) {
+  double ax = first.x - point.x;
+  double ay = first.y - point.y;
+  double bx = second.x - point.x;
+  double by = second.y - point.y;
+  double cx = third.x - point.x;
+  double cy = third.y - point.y;
+  double bxcy = bx * cy;
+  double cxby = cx * by;
+  double cxay = cx * ay;
+  double axcy = ax * cy;
+  double axby = ax * by;
+  double bxay = bx * ay;
+  double alift = ax * ax + ay * ay;
+  double blift = bx * bx + by * by;
+  double clift = cx * cx + cy * cy;
+  double det = alift * (bxcy - cxby) + blift * (cxay - axcy) +
+               clift * (axby - bxay);
+  double permanent = (std::abs(bxcy) + std::abs(cxby)) * alift +
+                     (std::abs(cxay) + std::abs(axcy)) * blift +
+                     (std::abs(axby) + std::abs(bxay)) * clift;
+  if (std::abs(det) > kInCircleBound * permanent) {
+    return Sign(det);
+  }
+  return InCircleExact(first, second, third, point);
+}
+
 class Line {
  public:
   Line() = default;
@@ -59,19 +336,25 @@ class Line {
                          : 0),
             shift_(point1.y - coefficient_ * point1.x),
             isVertical_(point2.x == point1.x),
-            vertical_(point2.x == point1.x ? point1.x : 0) {}
+            vertical_(point2.x == point1.x ? point1.x : 0),
+            first_(point1),
+            second_(point2) {}
 
   Line(double coefficient, double shift)
           : coefficient_(coefficient),
             shift_(shift),
             isVertical_(false),
-            vertical_(0) {}
+            vertical_(0),
+            first_(0, shift),
+            second_(1, coefficient + shift) {}
 
   Line(Point point, double coefficient)
           : coefficient_(coefficient),
             shift_(point.y - coefficient * point.x),
             isVertical_(false),
-            vertical_(0) {}
+            vertical_(0),
+            first_(point),
+            second_(point.x + 1, point.y + coefficient) {}
 
   double getCoefficient() const { return coefficient_; }
 
@@ -90,28 +373,22 @@ class Line {
   double shift_;
   bool isVertical_;
   double vertical_;
+  Point first_;
+  Point second_;
 };
 
 Point Line::intersection(const Line& other) const {
-  if (coefficient_ == other.coefficient_) {
-    if (shift_ == other.shift_) {
+  if (CrossOrientation(first_, second_, other.first_, other.second_) == 0) {
+    if (Orientation(other.first_, other.second_, first_) == 0) {
       throw("Lines match");
     }
     throw("No intersection");
   }
-  if (isVertical()) {
-    return Point(
-            getVerticalShift(),
-            getVerticalShift() * other.getCoefficient() + other.getShift());
-  }
-  if (other.isVertical()) {
-    return Point(other.getVerticalShift(),
-                 other.getVerticalShift() * getCoefficient() + getShift());
-  }
-  return Point((other.shift_ - shift_) / (coefficient_ - other.coefficient_),
-               coefficient_ * (other.shift_ - shift_) /
-               (coefficient_ - other.coefficient_) +
-               shift_);
+  double first_side = OrientedArea(other.first_, other.second_, first_);
+  double second_side = OrientedArea(other.first_, other.second_, second_);
+  double ratio = first_side / (first_side - second_side);
+  return Point(first_.x + ratio * (second_.x - first_.x),
+               first_.y + ratio * (second_.y - first_.y));
 }
 
 bool operator==(const Line& line1, const Line& line2) {
@@ -123,6 +400,39 @@ bool operator!=(const Line& line1, const Line& line2) {
   return !(line1 == line2);
 }
 
+std::pair<double, double> Range(const double* values, size_t size) {
+  double min[kLanes];
+  double max[kLanes];
+  for (size_t lane = 0; lane < kLanes; ++lane) {
+    min[lane] = values[0];
+    max[lane] = values[0];
+  }
+  size_t index = 0;
+  for (; index + kLanes <= size; index += kLanes) {
+    for (size_t lane = 0; lane < kLanes; ++lane) {
+      double value = values[index + lane];
+      min[lane] = value < min[lane] ? value : min[lane];
+      max[lane] = value > max[lane] ? value : max[lane];
+    }
+  }
+  for (; index < size; ++index) {
+    min[0] = std::min(min[0], values[index]);
+    max[0] = std::max(max[0], values[index]);
+  }
+  for (size_t lane = 1; lane < kLanes; ++lane) {
+    min[0] = std::min(min[0], min[lane]);
+    max[0] = std::max(max[0], max[lane]);
+  }
+  return {min[0], max[0]};
+}
+
+double RoundHalfAway(double value) {
+  double whole = trunc(value);
+  double rest = value - whole;
+  double carry = rest >= 0.5 ? 1.0 : (rest <= -0.5 ? -1.0 : 0.0);
+  return copysign(whole + carry, value);
+}
+
 double LineLength(Point first, Point second) {
   return sqrt((first.x - second.x) * (first.x - second.x) +
               (first.y - second.y) * (first.y - second.y));
@@ -134,54 +444,332 @@ double SquareTriangleGeron(double side1, double side2, double side3) {
               (perimeterpol - side3));
 }
 
+class VertexBuffer {
+ public:
+  VertexBuffer() = default;
+
+  explicit VertexBuffer(const std::vector<Point>& points);
+
+  VertexBuffer(const VertexBuffer& other);
+
+  VertexBuffer(VertexBuffer&& other) noexcept { swap(*this, other); }
+
+  VertexBuffer& operator=(const VertexBuffer& other);
+
+  VertexBuffer& operator=(VertexBuffer&& other) noexcept;
+
+  ~VertexBuffer() { deallocate(data_); }
+
+  size_t size() const { return size_; }
+
+  bool empty() const { return size_ == 0; }
+
+  Point operator[](size_t index) const {
+    return Point(data_[index], data_[cap_ + index]);
+  }
+
+  const double* xs() const { return data_; }
+
+  const double* ys() const { return data_ + cap_; }
+
+  double* xs() { return data_; }
+
+  double* ys() { return data_ + cap_; }
+
+  void push_back(Point point);
+
+  std::vector<Point> points() const;
+
+ private:
+  static constexpr size_t kAlignment = 64;
+  static constexpr size_t kBlock = kAlignment / sizeof(double);
+  size_t size_ = 0;
+  size_t cap_ = 0;
+  double* data_ = nullptr;
+
+  static double* allocate(size_t cap);
+
+  static void deallocate(double* data);
+
+  static void swap(VertexBuffer& first, VertexBuffer& second);
+
+  void reserve(size_t cap);
+};
+
+double* VertexBuffer::allocate(size_t cap) {
+  return static_cast<double*>(::operator new(
+          2 * cap * sizeof(double), std::align_val_t(kAlignment)));
+}
+
+void VertexBuffer::deallocate(double* data) {
+  if (data != nullptr) {
+    ::operator delete(data, std::align_val_t(kAlignment));
+  }
+}
+
+void VertexBuffer::swap(VertexBuffer& first, VertexBuffer& second) {
+  std::swap(first.size_, second.size_);
+  std::swap(first.cap_, second.cap_);
+  std::swap(first.data_, second.data_);
+}
+
+void VertexBuffer::reserve(size_t cap) {
+  cap = (cap + kBlock - 1) / kBlock * kBlock;
+  if (cap <= cap_) {
+    return;
+  }
+  double* data = allocate(cap);
+  std::copy(xs(), xs() + size_, data);
+  std::copy(ys(), ys() + size_, data + cap);
+  deallocate(data_);
+  data_ = data;
+  cap_ = cap;
+}
+
+VertexBuffer::VertexBuffer(const std::vector<Point>& points) {
+  reserve(points.size());
+  size_ = points.size();
+  double* xs = data_;
+  double* ys = data_ + cap_;
+  for (size_t i = 0; i < size_; ++i) {
+    xs[i] = points[i].x;
+    ys[i] = points[i].y;
+  }
+}
+
+VertexBuffer::VertexBuffer(const VertexBuffer& other) {
+  reserve(other.size_);
+  size_ = other.size_;
+  std::copy(other.xs(), other.xs() + size_, xs());
+  std::copy(other.ys(), other.ys() + size_, ys());
+}
+
+VertexBuffer& VertexBuffer::operator=(const VertexBuffer& other) {
+  VertexBuffer tmp(other);
+  swap(*this, tmp);
+  return *this;
+}
+
+VertexBuffer& VertexBuffer::operator=(VertexBuffer&& other) noexcept {
+  swap(*this, other);
+  return *this;
+}
+
+void VertexBuffer::push_back(Point point) {
+  if (size_ == cap_) {
+    reserve(2 * cap_ + 1);
+  }
+  data_[size_] = point.x;
+  data_[cap_ + size_] = point.y;
+  ++size_;
+}
+
+std::vector<Point> VertexBuffer::points() const {
+  std::vector<Point> points;
+  points.reserve(size_);
+  for (size_t i = 0; i < size_; ++i) {
+    points.emplace_back(data_[i], data_[cap_ + i]);
+  }
+  return points;
+}
+
+class AffineTransform {
+ public:
+  AffineTransform() = default;
+
+  AffineTransform(double xx, double xy, double x0, double yx, double yy,
+                  double y0)
+          : xx_(xx), xy_(xy), x0_(x0), yx_(yx), yy_(yy), y0_(y0) {}
+
+  static AffineTransform rotation(Point center, double angle);
+
+  static AffineTransform reflection(Point center);
+
+  static AffineTransform reflection(const Line& axis);
+
+  static AffineTransform scaling(Point center, double coefficient);
+
+  static AffineTransform translation(double dx, double dy);
+
+  AffineTransform then(const AffineTransform& next) const;
+
+  bool isIdentity() const;
+
+  Point operator()(Point point) const;
+
+  void apply(Point* points, size_t count) const;
+
+  void apply(double* xs, double* ys, size_t count) const;
+
+ private:
+  double xx_ = 1;
+  double xy_ = 0;
+  double x0_ = 0;
+  double yx_ = 0;
+  double yy_ = 1;
+  double y0_ = 0;
+  bool rounded_ = false;
+};
+
+AffineTransform AffineTransform::rotation(Point center, double angle) {
+  double cosine = cos(angle / kPig * M_PI);
+  double sine = sin(angle / kPig * M_PI);
+  AffineTransform transform(cosine, -sine,
+                            center.x - cosine * center.x + sine * center.y,
+                            sine, cosine,
+                            center.y - sine * center.x - cosine * center.y);
+  transform.rounded_ = true;
+  return transform;
+}
+
+AffineTransform AffineTransform::reflection(Point center) {
+  return AffineTransform(-1, 0, 2 * center.x, 0, -1, 2 * center.y);
+}
+
+AffineTransform AffineTransform::reflection(const Line& axis) {
+  if (axis.isVertical()) {
+    return AffineTransform(-1, 0, 2 * axis.getVerticalShift(), 0, 1, 0);
+  }
+  double slope = axis.getCoefficient();
+  double shift = axis.getShift();
+  double norm = 1 + slope * slope;
+  return AffineTransform((1 - slope * slope) / norm, 2 * slope / norm,
+                         -2 * slope * shift / norm, 2 * slope / norm,
+                         (slope * slope - 1) / norm, 2 * shift / norm);
+}
+
+AffineTransform AffineTransform::scaling(Point center, double coefficient) {
+  return AffineTransform(coefficient, 0, (1 - coefficient) * center.x, 0,
+                         coefficient, (1 - coefficient) * center.y);
+}
+
+AffineTransform AffineTransform::translation(double dx, double dy) {
+  return AffineTransform(1, 0, dx, 0, 1, dy);
+}
+
+AffineTransform AffineTransform::then(const AffineTransform& next) const {
+  AffineTransform transform(next.xx_ * xx_ + next.xy_ * yx_,
+                            next.xx_ * xy_ + next.xy_ * yy_,
+                            next.xx_ * x0_ + next.xy_ * y0_ + next.x0_,
+                            next.yx_ * xx_ + next.yy_ * yx_,
+                            next.yx_ * xy_ + next.yy_ * yy_,
+                            next.yx_ * x0_ + next.yy_ * y0_ + next.y0_);
+  transform.rounded_ = rounded_ || next.rounded_;
+  return transform;
+}
+
+bool AffineTransform::isIdentity() const {
+  return xx_ == 1 && xy_ == 0 && x0_ == 0 && yx_ == 0 && yy_ == 1 &&
+         y0_ == 0 && !rounded_;
+}
+
+Point AffineTransform::operator()(Point point) const {
+  apply(&point, 1);
+  return point;
+}
+
+void AffineTransform::apply(Point* points, size_t count) const {
+  for (size_t i = 0; i < count; ++i) {
+    double x = points[i].x;
+    double y = points[i].y;
+    points[i].x = xx_ * x + xy_ * y + x0_;
+    points[i].y = yx_ * x + yy_ * y + y0_;
+  }
+  if (!rounded_) {
+    return;
+  }
+  for (size_t i = 0; i < count; ++i) {
+    points[i].x = RoundHalfAway(points[i].x * kConst) / kConst;
+    points[i].y = RoundHalfAway(points[i].y * kConst) / kConst;
+  }
+}
+
+void AffineTransform::apply(double* xs, double* ys, size_t count) const {
+  const double xx = xx_;
+  const double xy = xy_;
+  const double x0 = x0_;
+  const double yx = yx_;
+  const double yy = yy_;
+  const double y0 = y0_;
+  for (size_t i = 0; i < count; ++i) {
+    double x = xs[i];
+    double y = ys[i];
+    xs[i] = xx * x + xy * y + x0;
+    ys[i] = yx * x + yy * y + y0;
+  }
+  if (!rounded_) {
+    return;
+  }
+  for (size_t i = 0; i < count; ++i) {
+    xs[i] = RoundHalfAway(xs[i] * kConst) / kConst;
+    ys[i] = RoundHalfAway(ys[i] * kConst) / kConst;
+  }
+}
+
 void RotatePoint(Point center, double angle, Point& vertice) {
-  vertice = Point(
-          round(((vertice.x - center.x) * cos(angle / kPig * M_PI) -
-                 (vertice.y - center.y) * sin(angle / kPig * M_PI) + center.x) *
-                kConst) /
-          kConst,
-          round(((vertice.x - center.x) * sin(angle / kPig * M_PI) +
-                 (vertice.y - center.y) * cos(angle / kPig * M_PI) + center.y) *
-                kConst) /
-          kConst);
+  vertice = AffineTransform::rotation(center, angle)(vertice);
 }
 
 void ReflectPoint(Point center, Point& vertice) {
-  vertice = Point(2 * center.x - vertice.x, 2 * center.y - vertice.y);
+  vertice = AffineTransform::reflection(center)(vertice);
 }
 
 void ReflectPoint(const Line& axis, Point& vertice) {
-  if (axis.getCoefficient() == 0) {
-    if (axis.isVertical()) {
-      vertice.x = -vertice.x;
-    } else {
-      vertice.y = -vertice.y;
-    }
-  } else {
-    double coeff = -1 / axis.getCoefficient();
-    Line oxis(vertice, coeff);
-    Point intersection_point = oxis.intersection(axis);
-    ReflectPoint(intersection_point, vertice);
-  }
+  vertice = AffineTransform::reflection(axis)(vertice);
 }
 
 void ScalePoint(Point center, double coefficient, Point& vertice) {
-  double len = coefficient * LineLength(center, vertice);
-  Line line(center, vertice);
-  if (vertice < center) {
-    len *= -1;
+  vertice = AffineTransform::scaling(center, coefficient)(vertice);
+}
+
+struct BoundingBox {
+  Point min;  //  NOLINT
+  Point max;  //  NOLINT
+
+  BoundingBox() = default;
+
+  BoundingBox(Point min, Point max) : min(min), max(max) {}  //  NOLINT
+
+  bool contains(Point point) const {
+    return min.x <= point.x && point.x <= max.x && min.y <= point.y &&
+           point.y <= max.y;
   }
-  if (line.isVertical()) {
-    vertice.y = center.y + len;
-  } else {
-    vertice.x = center.x +
-                len / sqrt(1 + line.getCoefficient() * line.getCoefficient());
-    vertice.y = vertice.x * line.getCoefficient() + line.getShift();
+
+  bool intersects(const BoundingBox& other) const {
+    return min.x <= other.max.x && other.min.x <= max.x &&
+           min.y <= other.max.y && other.min.y <= max.y;
+  }
+
+  double distance(Point point) const;
+
+  Point center() const {
+    return Point(min.x / 2 + max.x / 2, min.y / 2 + max.y / 2);
   }
+
+  void expand(const BoundingBox& other);
+};
+
+double BoundingBox::distance(Point point) const {
+  double dx = std::max({min.x - point.x, 0.0, point.x - max.x});
+  double dy = std::max({min.y - point.y, 0.0, point.y - max.y});
+  return sqrt(dx * dx + dy * dy);
 }
 
+void BoundingBox::expand(const BoundingBox& other) {
+  min = Point(std::min(min.x, other.min.x), std::min(min.y, other.min.y));
+  max = Point(std::max(max.x, other.max.x), std::max(max.y, other.max.y));
+}
+
+class ShapeIndex;
+
 class Shape {
  public:
+  Shape() = default;
+
+  Shape(const Shape& other) = default;
+
+  Shape& operator=(const Shape& other) = default;
+
   virtual double area() = 0;
 
   virtual double perimeter() = 0;
@@ -202,33 +790,40 @@ class Shape {
 
   virtual bool isCongruentTo(const Shape& another) = 0;
 
-  virtual ~Shape() = default;
+  virtual BoundingBox boundingBox() = 0;
+
+  virtual ~Shape();
+
+ protected:
+  void touch();
+
+ private:
+  // The ShapeIndex entries that hold this shape. They belong to the object,
+  // not to its value: a copy starts unindexed and an assignment keeps the
+  // entries of the target.
+  struct Slots {
+    std::vector<std::pair<ShapeIndex*, size_t>> entries;
+
+    Slots() = default;
+
+    Slots(const Slots& /*other*/) {}
+
+    Slots& operator=(const Slots& /*other*/) { return *this; }
+  };
+
+  Slots slots_;
+
+  friend class ShapeIndex;
 };
 
 bool LeftFromLine(Point point1, Point point2, Point point3) {
-  bool left_from_line;
-  Line line(point1, point3);
-  if (line.isVertical()) {
-    left_from_line = point2.x <= line.getVerticalShift();
-    if (point3.y < point1.y) {
-      left_from_line = !left_from_line;
-    }
-  } else {
-    left_from_line =
-            point2.y >= (line.getCoefficient() * point2.x + line.getShift());
-    if (line.getCoefficient() < 0 && line.getCoefficient() != 0) {
-      left_from_line = !left_from_line;
-    }
-    if ((point3.y < point1.y && line.getCoefficient() != 0) ||
-        (line.getCoefficient() == 0 && point3.x < point1.x)) {
-      left_from_line = !left_from_line;
-    }
-  }
-  return left_from_line;
+  return Orientation(point1, point3, point2) >= 0;
 }
 
 class Polygon : public Shape {
  public:
+  enum class Location { kOutside, kBoundary, kInside };
+
   Polygon() = default;
 
   template <typename... Points>
@@ -238,15 +833,25 @@ class Polygon : public Shape {
 
   size_t verticesCount() const { return vertices_.size(); }
 
-  bool isConvex();
+  bool isConvex() const;
 
   double area() override;
 
   double perimeter() override;
 
+  Point centroid();
+
   std::string showFigureType() override { return typeid(*this).name(); }
 
-  std::vector<Point> getVertices() const { return vertices_; }
+  std::vector<Point> getVertices() const {
+    flush();
+    return vertices_.points();
+  }
+
+  const VertexBuffer& vertices() const {
+    flush();
+    return vertices_;
+  }
 
   void rotate(Point center, double angle) override;
 
@@ -256,19 +861,63 @@ class Polygon : public Shape {
 
   void scale(Point center, double coefficient) override;
 
+  void transform(const AffineTransform& transform);
+
   bool containsPoint(Point point) override;
 
+  Location locate(Point point);
+
+  std::vector<bool> containsPoints(const Point* points, size_t count) const;
+
+  std::vector<bool> containsPoints(const std::vector<Point>& points) const {
+    return containsPoints(points.data(), points.size());
+  }
+
   bool isSimilarTo(const Shape& another) override;
 
   bool isCongruentTo(const Shape& another) override;
 
+  BoundingBox boundingBox() override;
+
+  static void setThreadCount(size_t count);
+
+  static size_t threadCount();
+
   ~Polygon() = default;
 
   bool isSame(const Polygon& polygon);
 
  protected:
-  std::vector<Point> vertices_;
-  int convex_ = 0;
+  mutable VertexBuffer vertices_;
+  mutable int convex_ = 0;
+
+  void flush() const;
+
+ private:
+  double area_ = 0;
+  double perimeter_ = 0;
+  Point mass_center_ = {0, 0};
+  bool area_cached_ = false;
+  bool perimeter_cached_ = false;
+  // Filled in by const queries, so a Polygon must not be queried from
+  // several threads until the first query has returned.
+  mutable std::vector<Point> fan_;
+  mutable AffineTransform pending_;
+
+  static constexpr size_t kPointBlock = 256;
+  static const size_t kParallelWork = 1 << 18;
+
+  void computeArea();
+
+  void buildFan() const;
+
+  Location locateInFan(Point point) const;
+
+  Location locateByWinding(Point point) const;
+
+  void locatePoints(const Point* points, size_t count, char* inside) const;
+
+  static std::atomic<size_t>& threads();
 };
 
 template <typename... Points>
@@ -277,7 +926,7 @@ Polygon::Polygon(const Point& point, const Points&... tail) : Polygon(tail...) {
   vertices_.push_back(point);
 }
 
-bool Polygon::isConvex() {
+bool Polygon::isConvex() const {
   if (convex_ != 0) {
     return convex_ == 1;
   }
@@ -285,104 +934,354 @@ bool Polygon::isConvex() {
     convex_ = 1;
     return true;
   }
-  bool left_from_line_last;
+  flush();
+  int turn_last = 0;
   for (size_t i = 0; i < vertices_.size(); ++i) {
     Point point1 = vertices_[i];
     Point point2 = vertices_[(i + 1) % vertices_.size()];
     Point point3 = vertices_[(i + 2) % vertices_.size()];
-    bool left_from_line = LeftFromLine(point1, point2, point3);
-    if (i != 0) {
-      if (left_from_line != left_from_line_last) {
-        convex_ = -1;
-        return false;
-      }
+    int turn = Orientation(point1, point2, point3);
+    if (turn == 0 || (i != 0 && turn != turn_last)) {
+      convex_ = -1;
+      return false;
     }
-    left_from_line_last = left_from_line;
+    turn_last = turn;
   }
   convex_ = 1;
   return true;
 }
 
-double Polygon::area() {
-  if (vertices_.size() == kTrvert) {
-    return SquareTriangleGeron(LineLength(vertices_[0], vertices_[1]),
-                               LineLength(vertices_[1], vertices_[2]),
-                               LineLength(vertices_[2], vertices_[0]));
-  }
-
-  double ans = 0;
-  int sign;
-  bool left_from_line_first;
-  for (size_t i = 0; i < vertices_.size() - 2; ++i) {
-    sign = 1;
-    Point point1 = vertices_[0];
-    Point point2 = vertices_[i + 1];
-    Point point3 = vertices_[i + 2];
-    bool left_from_line = LeftFromLine(point1, point2, point3);
-    if (i != 0) {
-      if (left_from_line != left_from_line_first) {
-        sign = -1;
-      }
-    } else {
-      left_from_line_first = left_from_line;
+void Polygon::computeArea() {
+  flush();
+  size_t size = vertices_.size();
+  const double* xs = vertices_.xs();
+  const double* ys = vertices_.ys();
+  Point origin = vertices_[0];
+  double cross[kLanes] = {};
+  double moment_x[kLanes] = {};
+  double moment_y[kLanes] = {};
+  size_t index = 0;
+  for (; index + kLanes < size; index += kLanes) {
+    for (size_t lane = 0; lane < kLanes; ++lane) {
+      double x1 = xs[index + lane] - origin.x;
+      double y1 = ys[index + lane] - origin.y;
+      double x2 = xs[index + lane + 1] - origin.x;
+      double y2 = ys[index + lane + 1] - origin.y;
+      double term = x1 * y2 - x2 * y1;
+      cross[lane] += term;
+      moment_x[lane] += (x1 + x2) * term;
+      moment_y[lane] += (y1 + y2) * term;
+    }
+  }
+  for (; index < size; ++index) {
+    Point next = vertices_[(index + 1) % size];
+    double x1 = xs[index] - origin.x;
+    double y1 = ys[index] - origin.y;
+    double x2 = next.x - origin.x;
+    double y2 = next.y - origin.y;
+    double term = x1 * y2 - x2 * y1;
+    cross[0] += term;
+    moment_x[0] += (x1 + x2) * term;
+    moment_y[0] += (y1 + y2) * term;
+  }
+  double doubled_area = 0;
+  Point moment = {0, 0};
+  for (size_t lane = 0; lane < kLanes; ++lane) {
+    doubled_area += cross[lane];
+    moment.x += moment_x[lane];
+    moment.y += moment_y[lane];
+  }
+  area_ = std::abs(doubled_area) / 2;
+  if (doubled_area != 0) {
+    mass_center_ = Point(origin.x + moment.x / (kTrvert * doubled_area),
+                         origin.y + moment.y / (kTrvert * doubled_area));
+  } else {
+    mass_center_ = {0, 0};
+    for (size_t i = 0; i < size; ++i) {
+      mass_center_.x += xs[i] / size;
+      mass_center_.y += ys[i] / size;
     }
-    ans += sign * SquareTriangleGeron(LineLength(point1, point2),
-                                      LineLength(point2, point3),
-                                      LineLength(point3, point1));
   }
-  return abs(ans);
+  area_cached_ = true;
+}
+
+double Polygon::area() {
+  if (!area_cached_) {
+    computeArea();
+  }
+  return area_;
+}
+
+Point Polygon::centroid() {
+  if (!area_cached_) {
+    computeArea();
+  }
+  return mass_center_;
 }
 
 double Polygon::perimeter() {
-  double ans = 0;
-  for (size_t i = 0; i < vertices_.size(); ++i) {
-    Point point1 = vertices_[i];
-    Point point2 = vertices_[(i + 1) % vertices_.size()];
-    ans += LineLength(point1, point2);
+  if (perimeter_cached_) {
+    return perimeter_;
+  }
+  flush();
+  size_t size = vertices_.size();
+  const double* xs = vertices_.xs();
+  const double* ys = vertices_.ys();
+  double ans = LineLength(vertices_[size - 1], vertices_[0]);
+  for (size_t i = 0; i + 1 < size; ++i) {
+    double dx = xs[i + 1] - xs[i];
+    double dy = ys[i + 1] - ys[i];
+    ans += sqrt(dx * dx + dy * dy);
   }
+  perimeter_ = ans;
+  perimeter_cached_ = true;
   return ans;
 }
 
 void Polygon::rotate(Point center, double angle) {
-  for (auto& vertice : vertices_) {
-    RotatePoint(center, angle, vertice);
-  }
+  transform(AffineTransform::rotation(center, angle));
 }
 
 void Polygon::reflect(Point center) {
-  for (auto& vertice : vertices_) {
-    ReflectPoint(center, vertice);
-  }
+  transform(AffineTransform::reflection(center));
 }
 
 void Polygon::reflect(const Line& axis) {
-  for (auto& vertice : vertices_) {
-    ReflectPoint(axis, vertice);
-  }
+  transform(AffineTransform::reflection(axis));
 }
 
 void Polygon::scale(Point center, double coefficient) {
-  for (auto& vertice : vertices_) {
-    ScalePoint(center, coefficient, vertice);
+  transform(AffineTransform::scaling(center, coefficient));
+}
+
+void Polygon::transform(const AffineTransform& transform) {
+  pending_ = pending_.then(transform);
+  area_cached_ = perimeter_cached_ = false;
+  fan_.clear();
+  touch();
+}
+
+void Polygon::flush() const {
+  if (!pending_.isIdentity()) {
+    pending_.apply(vertices_.xs(), vertices_.ys(), vertices_.size());
+    pending_ = AffineTransform();
   }
 }
 
+BoundingBox Polygon::boundingBox() {
+  flush();
+  std::pair<double, double> x_range = Range(vertices_.xs(), vertices_.size());
+  std::pair<double, double> y_range = Range(vertices_.ys(), vertices_.size());
+  return BoundingBox(Point(x_range.first, y_range.first),
+                     Point(x_range.second, y_range.second));
+}
+
 bool Polygon::containsPoint(Point point) {
-  bool last = LeftFromLine(vertices_[0], point, vertices_[1]);
-  for (size_t i = 1; i < vertices_.size(); ++i) {
-    bool left_from_line = LeftFromLine(vertices_[i], point,
-                                       vertices_[(i + 1) % vertices_.size()]);
-    if (left_from_line != last) {
-      return false;
+  return locate(point) != Location::kOutside;
+}
+
+Polygon::Location Polygon::locate(Point point) {
+  flush();
+  if (vertices_.size() < kTrvert || !isConvex()) {
+    return locateByWinding(point);
+  }
+  if (fan_.empty()) {
+    buildFan();
+  }
+  return locateInFan(point);
+}
+
+void Polygon::buildFan() const {
+  fan_ = vertices_.points();
+  if (Orientation(fan_[0], fan_[1], fan_[2]) < 0) {
+    std::reverse(fan_.begin(), fan_.end());
+  }
+  std::rotate(fan_.begin(), std::min_element(fan_.begin(), fan_.end()),
+              fan_.end());
+}
+
+Polygon::Location Polygon::locateInFan(Point point) const {
+  size_t last = fan_.size() - 1;
+  Point origin = fan_[0];
+  int first_side = Orientation(origin, fan_[1], point);
+  int last_side = Orientation(origin, fan_[last], point);
+  if (first_side < 0 || last_side > 0) {
+    return Location::kOutside;
+  }
+  for (size_t edge : {size_t(1), last}) {
+    if ((edge == 1 ? first_side : last_side) != 0) {
+      continue;
     }
-    last = left_from_line;
+    bool between = std::min(origin.x, fan_[edge].x) <= point.x &&
+                   point.x <= std::max(origin.x, fan_[edge].x) &&
+                   std::min(origin.y, fan_[edge].y) <= point.y &&
+                   point.y <= std::max(origin.y, fan_[edge].y);
+    return between ? Location::kBoundary : Location::kOutside;
   }
-  return true;
+  size_t low = 1;
+  size_t length = last - 1;
+  bool unsure = false;
+  while (length > 1) {
+    size_t half = length / 2;
+    Point middle = fan_[low + half];
+    double left = (middle.x - origin.x) * (point.y - origin.y);
+    double right = (middle.y - origin.y) * (point.x - origin.x);
+    double cross = left - right;
+    unsure |= std::abs(cross) <=
+              kOrientationBound * (std::abs(left) + std::abs(right));
+    low = cross >= 0 ? low + half : low;
+    length -= half;
+  }
+  if (unsure) {
+    while (low > 1 && Orientation(origin, fan_[low], point) < 0) {
+      --low;
+    }
+    while (low + 1 < last &&
+           Orientation(origin, fan_[low + 1], point) >= 0) {
+      ++low;
+    }
+  }
+  int side = Orientation(fan_[low], fan_[low + 1], point);
+  if (side < 0) {
+    return Location::kOutside;
+  }
+  return side == 0 ? Location::kBoundary : Location::kInside;
+}
+
+Polygon::Location Polygon::locateByWinding(Point point) const {
+  int winding = 0;
+  size_t size = vertices_.size();
+  const double* ys = vertices_.ys();
+  for (size_t prev = size - 1, i = 0; i < size; prev = i++) {
+    if (point.y < std::min(ys[prev], ys[i]) ||
+        point.y > std::max(ys[prev], ys[i])) {
+      continue;
+    }
+    Point first = vertices_[prev];
+    Point second = vertices_[i];
+    int cross = Orientation(first, second, point);
+    if (cross == 0 && std::min(first.x, second.x) <= point.x &&
+        point.x <= std::max(first.x, second.x)) {
+      return Location::kBoundary;
+    }
+    if (first.y <= point.y && second.y > point.y && cross > 0) {
+      ++winding;
+    } else if (first.y > point.y && second.y <= point.y && cross < 0) {
+      --winding;
+    }
+  }
+  return winding != 0 ? Location::kInside : Location::kOutside;
+}
+
+std::vector<bool> Polygon::containsPoints(const Point* points,
+                                          size_t count) const {
+  flush();
+  std::vector<char> inside(count);
+  if (fan_.empty() && vertices_.size() >= kTrvert && isConvex()) {
+    buildFan();
+  }
+  size_t cost = fan_.empty() ? vertices_.size()
+                             : static_cast<size_t>(log2(fan_.size())) + 1;
+  size_t workers = std::min(threadCount(), count * cost / kParallelWork + 1);
+  size_t chunk = (count + workers - 1) / std::max<size_t>(workers, 1);
+  std::vector<std::thread> threads;
+  size_t begin = chunk;
+  for (; begin < count; begin += chunk) {
+    size_t size = std::min(chunk, count - begin);
+    try {
+      threads.emplace_back([this, points, begin, size, &inside]() {
+        locatePoints(points + begin, size, inside.data() + begin);
+      });
+    } catch (const std::system_error&) {
+      break;
+    }
+  }
+  locatePoints(points, std::min(chunk, count), inside.data());
+  for (; begin < count; begin += chunk) {
+    locatePoints(points + begin, std::min(chunk, count - begin),
+                 inside.data() + begin);
+  }
+  for (auto& thread : threads) {
+    thread.join();
+  }
+  return std::vector<bool>(inside.begin(), inside.end());
+}
+
+void Polygon::locatePoints(const Point* points, size_t count,
+                           char* inside) const {
+  if (!fan_.empty()) {
+    for (size_t j = 0; j < count; ++j) {
+      inside[j] = static_cast<char>(locateInFan(points[j]) !=
+                                    Location::kOutside);
+    }
+    return;
+  }
+  double xs[kPointBlock];
+  double ys[kPointBlock];
+  double winding[kPointBlock];
+  double uncertain[kPointBlock];
+  size_t size = vertices_.size();
+  for (size_t begin = 0; begin < count; begin += kPointBlock) {
+    size_t block = std::min(kPointBlock, count - begin);
+    double low = points[begin].y;
+    double high = points[begin].y;
+    for (size_t j = 0; j < block; ++j) {
+      xs[j] = points[begin + j].x;
+      ys[j] = points[begin + j].y;
+      low = std::min(low, ys[j]);
+      high = std::max(high, ys[j]);
+      winding[j] = 0;
+      uncertain[j] = 0;
+    }
+    for (size_t i = 0; i < size; ++i) {
+      Point first = vertices_[i];
+      Point second = vertices_[i + 1 == size ? 0 : i + 1];
+      double min_y = std::min(first.y, second.y);
+      double max_y = std::max(first.y, second.y);
+      if (max_y < low || min_y > high) {
+        continue;
+      }
+      double direction = first.y <= second.y ? 1.0 : -1.0;
+      double dx = (second.x - first.x) * direction;
+      double dy = (second.y - first.y) * direction;
+      for (size_t j = 0; j < block; ++j) {
+        double left = dx * (ys[j] - first.y);
+        double right = dy * (xs[j] - first.x);
+        double cross = left - right;
+        double bound = kOrientationBound * (std::abs(left) + std::abs(right));
+        bool spans = (min_y <= ys[j]) & (ys[j] <= max_y);
+        bool crossing = spans & (ys[j] != max_y) & (cross > 0);
+        bool unsure = spans & (std::abs(cross) <= bound);
+        winding[j] += crossing ? direction : 0.0;
+        uncertain[j] += unsure ? 1.0 : 0.0;
+      }
+    }
+    for (size_t j = 0; j < block; ++j) {
+      inside[begin + j] = static_cast<char>(winding[j] != 0);
+      if (uncertain[j] != 0) {
+        inside[begin + j] = static_cast<char>(
+                locateByWinding(points[begin + j]) != Location::kOutside);
+      }
+    }
+  }
+}
+
+void Polygon::setThreadCount(size_t count) {
+  threads() = std::max<size_t>(count, 1);
+}
+
+size_t Polygon::threadCount() { return threads(); }
+
+std::atomic<size_t>& Polygon::threads() {
+  static std::atomic<size_t> count{1};
+  return count;
 }
 
 bool Polygon::isSame(const Polygon& polygon) {
-  std::vector<Point> arr1 = vertices_;
-  std::vector<Point> arr2 = polygon.vertices_;
+  flush();
+  polygon.flush();
+  std::vector<Point> arr1 = vertices_.points();
+  std::vector<Point> arr2 = polygon.vertices_.points();
   if (arr1.size() != arr2.size()) {
     return false;
   }
@@ -445,6 +1344,8 @@ class Ellipse : public Shape {
 
   bool isSame(const Ellipse& other) const;
 
+  BoundingBox boundingBox() override;
+
   ~Ellipse() = default;
 
  protected:
@@ -455,6 +1356,9 @@ class Ellipse : public Shape {
   double small_semi_axis_;
   std::pair<Line, Line> directrices_;
   Point center_;
+
+ private:
+  void apply(const AffineTransform& transform, double ratio);
 };
 
 double Ellipse::area() { return M_PI * big_semi_axis_ * small_semi_axis_; }
@@ -466,27 +1370,25 @@ double Ellipse::perimeter() {
 }
 
 void Ellipse::rotate(Point center, double angle) {
-  RotatePoint(center, angle, focuses_.first);
-  RotatePoint(center, angle, focuses_.second);
-  *this = Ellipse(focuses_.first, focuses_.second, 2 * big_semi_axis_);
+  apply(AffineTransform::rotation(center, angle), 1);
 }
 
 void Ellipse::reflect(Point center) {
-  ReflectPoint(center, focuses_.first);
-  ReflectPoint(center, focuses_.second);
-  *this = Ellipse(focuses_.first, focuses_.second, 2 * big_semi_axis_);
+  apply(AffineTransform::reflection(center), 1);
 }
 
 void Ellipse::reflect(const Line& axis) {
-  ReflectPoint(axis, focuses_.first);
-  ReflectPoint(axis, focuses_.second);
-  *this = Ellipse(focuses_.first, focuses_.second, 2 * big_semi_axis_);
+  apply(AffineTransform::reflection(axis), 1);
 }
 
 void Ellipse::scale(Point center, double coefficient) {
-  ScalePoint(center, coefficient, focuses_.first);
-  ScalePoint(center, coefficient, focuses_.second);
-  *this = Ellipse(focuses_.first, focuses_.second, 2 * big_semi_axis_);
+  apply(AffineTransform::scaling(center, coefficient), std::abs(coefficient));
+}
+
+void Ellipse::apply(const AffineTransform& transform, double ratio) {
+  *this = Ellipse(transform(focuses_.first), transform(focuses_.second),
+                  2 * big_semi_axis_ * ratio);
+  touch();
 }
 
 bool Ellipse::containsPoint(Point point) {
@@ -496,6 +1398,21 @@ bool Ellipse::containsPoint(Point point) {
           ((point.y - center_.y) / small_semi_axis_)) < 1;
 }
 
+BoundingBox Ellipse::boundingBox() {
+  double cosine = 1;
+  double sine = 0;
+  if (focal_length_ != 0) {
+    cosine = (focuses_.second.x - focuses_.first.x) / (2 * focal_length_);
+    sine = (focuses_.second.y - focuses_.first.y) / (2 * focal_length_);
+  }
+  double big = big_semi_axis_ * big_semi_axis_;
+  double small = small_semi_axis_ * small_semi_axis_;
+  double half_width = sqrt(big * cosine * cosine + small * sine * sine);
+  double half_height = sqrt(big * sine * sine + small * cosine * cosine);
+  return BoundingBox(Point(center_.x - half_width, center_.y - half_height),
+                     Point(center_.x + half_width, center_.y + half_height));
+}
+
 bool Ellipse::isSame(const Ellipse& other) const {
   return (focuses_.first == other.focuses_.first) &&
          (focuses_.second == other.focuses_.second);
@@ -594,7 +1511,7 @@ std::vector<Point> ReverseVertices(Point point1, Point point2, Point point3) {
 }
 
 Triangle::Triangle(Point point1, Point point2, Point point3) {
-  vertices_ = ReverseVertices(point1, point2, point3);
+  vertices_ = VertexBuffer(ReverseVertices(point1, point2, point3));
   Point mid1(vertices_[0].x / 2 + vertices_[1].x / 2,
              vertices_[0].y / 2 + vertices_[1].y / 2);
   Point mid2(vertices_[1].x / 2 + vertices_[2].x / 2,
@@ -626,6 +1543,7 @@ Triangle::Triangle(Point point1, Point point2, Point point3) {
 }
 
 Circle Triangle::circumscribedCircle() {
+  flush();
   Point mid1(vertices_[0].x / 2 + vertices_[1].x / 2,
              vertices_[0].y / 2 + vertices_[1].y / 2);
   Line side1(vertices_[0], vertices_[1]);
@@ -655,6 +1573,7 @@ Circle Triangle::circumscribedCircle() {
 }
 
 Circle Triangle::inscribedCircle() {
+  flush();
   double len_side1 = LineLength(vertices_[0], vertices_[1]);
   double len_side2 = LineLength(vertices_[1], vertices_[2]);
   double len_side3 = LineLength(vertices_[2], vertices_[0]);
@@ -676,6 +1595,7 @@ Circle Triangle::inscribedCircle() {
 }
 
 Circle Triangle::ninePointsCircle() {
+  flush();
   Point mid1(vertices_[0].x / 2 + vertices_[1].x / 2,
              vertices_[0].y / 2 + vertices_[1].y / 2);
   Point mid2(vertices_[1].x / 2 + vertices_[2].x / 2,
@@ -757,4 +1677,631 @@ bool operator==(const Shape& figure1, const Shape& figure2) {
     return pol1->isSame(*pol2);
   }
   return false;
-}
\ No newline at end of file
+}
+template <typename Iterator>
+void AppendHullChain(Iterator begin, Iterator end, std::vector<Point>& chain) {
+  for (Iterator it = begin; it != end; ++it) {
+    while (chain.size() >= 2 &&
+           Orientation(chain[chain.size() - 2], chain.back(), *it) <= 0) {
+      chain.pop_back();
+    }
+    chain.push_back(*it);
+  }
+}
+
+std::vector<Point> HullOfSorted(const std::vector<Point>& sorted) {
+  if (sorted.size() < kTrvert) {
+    return sorted;
+  }
+  std::vector<Point> hull;
+  std::vector<Point> upper;
+  hull.reserve(sorted.size());
+  upper.reserve(sorted.size());
+  AppendHullChain(sorted.begin(), sorted.end(), hull);
+  AppendHullChain(sorted.rbegin(), sorted.rend(), upper);
+  hull.pop_back();
+  hull.insert(hull.end(), upper.begin(), upper.end() - 1);
+  return hull;
+}
+
+std::vector<Point> HullCandidates(const std::vector<Point>& sorted) {
+  if (sorted.size() < kTrvert) {
+    return sorted;
+  }
+  std::vector<Point> lower;
+  std::vector<Point> upper;
+  lower.reserve(sorted.size());
+  upper.reserve(sorted.size());
+  AppendHullChain(sorted.begin(), sorted.end(), lower);
+  AppendHullChain(sorted.rbegin(), sorted.rend(), upper);
+  std::vector<Point> candidates(lower.size() + upper.size());
+  std::merge(lower.begin(), lower.end(), upper.rbegin(), upper.rend(),
+             candidates.begin());
+  candidates.erase(std::unique(candidates.begin(), candidates.end()),
+                   candidates.end());
+  return candidates;
+}
+
+std::vector<Point> HullFilter(const Point* points, size_t count) {
+  const double kDirections[8][2] = {{-1, 0}, {-1, -1}, {0, -1}, {1, -1},
+                                    {1, 0},  {1, 1},   {0, 1},  {-1, 1}};
+  Point extremes[8];
+  double best[8];
+  for (size_t k = 0; k < 8; ++k) {
+    extremes[k] = points[0];
+    best[k] = kDirections[k][0] * points[0].x + kDirections[k][1] * points[0].y;
+  }
+  for (size_t i = 1; i < count; ++i) {
+    for (size_t k = 0; k < 8; ++k) {
+      double value =
+              kDirections[k][0] * points[i].x + kDirections[k][1] * points[i].y;
+      if (value > best[k]) {
+        best[k] = value;
+        extremes[k] = points[i];
+      }
+    }
+  }
+  std::vector<Point> ring;
+  for (Point extreme : extremes) {
+    if (ring.empty() || ring.back() != extreme) {
+      ring.push_back(extreme);
+    }
+  }
+  while (ring.size() > 1 && ring.back() == ring.front()) {
+    ring.pop_back();
+  }
+  if (ring.size() < kTrvert) {
+    ring.clear();
+  }
+  return ring;
+}
+
+std::vector<Point> HullSlice(const Point* points, size_t count,
+                             const std::vector<Point>& ring) {
+  std::vector<Point> kept;
+  kept.reserve(count);
+  for (size_t i = 0; i < count; ++i) {
+    bool inside = !ring.empty();
+    for (size_t k = 0; inside && k < ring.size(); ++k) {
+      inside = Orientation(ring[k], ring[k + 1 == ring.size() ? 0 : k + 1],
+                           points[i]) > 0;
+    }
+    if (!inside) {
+      kept.push_back(points[i]);
+    }
+  }
+  std::sort(kept.begin(), kept.end());
+  kept.erase(std::unique(kept.begin(), kept.end()), kept.end());
+  return kept;
+}
+
+Polygon ConvexHull(const Point* points, size_t count) {
+  std::vector<Point> ring;
+  if (count >= kHullFilter) {
+    ring = HullFilter(points, count);
+  }
+  size_t workers = std::min(Polygon::threadCount(), count / kParallelHull + 1);
+  if (workers <= 1) {
+    return Polygon(HullOfSorted(HullSlice(points, count, ring)));
+  }
+  size_t chunk = (count + workers - 1) / workers;
+  std::vector<std::vector<Point>> candidates((count + chunk - 1) / chunk);
+  auto reduce = [points, count, chunk, &ring, &candidates](size_t part) {
+    size_t begin = part * chunk;
+    candidates[part] = HullCandidates(
+            HullSlice(points + begin, std::min(chunk, count - begin), ring));
+  };
+  std::vector<std::thread> threads;
+  size_t part = 1;
+  for (; part < candidates.size(); ++part) {
+    try {
+      threads.emplace_back(reduce, part);
+    } catch (const std::system_error&) {
+      break;
+    }
+  }
+  reduce(0);
+  for (; part < candidates.size(); ++part) {
+    reduce(part);
+  }
+  for (auto& thread : threads) {
+    thread.join();
+  }
+  std::vector<Point> merged;
+  std::vector<size_t> bounds(1, 0);
+  for (const auto& part_candidates : candidates) {
+    merged.insert(merged.end(), part_candidates.begin(), part_candidates.end());
+    bounds.push_back(merged.size());
+  }
+  for (size_t width = 1; width + 1 < bounds.size(); width *= 2) {
+    for (size_t first = 0; first + width + 1 < bounds.size();
+         first += 2 * width) {
+      size_t last = std::min(first + 2 * width, bounds.size() - 1);
+      std::inplace_merge(merged.begin() + bounds[first],
+                         merged.begin() + bounds[first + width],
+                         merged.begin() + bounds[last]);
+    }
+  }
+  merged.erase(std::unique(merged.begin(), merged.end()), merged.end());
+  return Polygon(HullOfSorted(merged));
+}
+
+Polygon ConvexHull(const std::vector<Point>& points) {
+  return ConvexHull(points.data(), points.size());
+}
+
+Polygon ConvexHull(const Polygon& polygon) {
+  return ConvexHull(polygon.getVertices());
+}
+
+// Bulk loaded over the current bounding boxes. A transform marks the shape
+// dirty in every index that holds it, and the next query re-reads only the
+// dirty boxes: the R-tree refits the path from the leaf to the root and
+// the grid moves the entry between cells. Neither repacks, so once the
+// number of updates since the last build exceeds the number of entries
+// the index is bulk loaded again over the current boxes, which also
+// re-derives the grid bounds. Shapes may be transformed from several
+// threads, but not while the index is queried.
+class ShapeIndex {
+ public:
+  enum class Layout { kRTree, kGrid };
+
+  explicit ShapeIndex(const std::vector<Shape*>& shapes,
+                      Layout layout = Layout::kRTree);
+
+  ShapeIndex(const ShapeIndex&) = delete;
+
+  ShapeIndex& operator=(const ShapeIndex&) = delete;
+
+  ~ShapeIndex();
+
+  size_t size() const { return entries_.size(); }
+
+  std::vector<Shape*> containing(Point point);
+
+  std::vector<Shape*> intersecting(const BoundingBox& box);
+
+  Shape* nearest(Point point);
+
+  void rebuild();
+
+ private:
+  struct Entry {
+    Shape* shape;
+    BoundingBox box;
+    size_t leaf;
+    bool dirty;
+  };
+
+
+  struct Node {
+    BoundingBox box;
+    size_t first;
+    size_t count;
+    size_t parent;
+    bool leaf;
+  };
+
+  static constexpr size_t kNodeCapacity = 16;
+  static constexpr size_t kNone = std::numeric_limits<size_t>::max();
+
+  Layout layout_;
+  std::vector<Entry> entries_;
+  std::vector<Node> nodes_;
+  BoundingBox bounds_;
+  size_t columns_ = 1;
+  size_t rows_ = 1;
+  double cell_width_ = 1;
+  double cell_height_ = 1;
+  std::vector<std::vector<size_t>> cells_;
+  std::vector<size_t> seen_;
+  size_t stamp_ = 0;
+  std::mutex dirty_mutex_;
+  std::vector<size_t> dirty_;
+  size_t moved_ = 0;
+
+  static std::vector<size_t> PackOrder(const std::vector<BoundingBox>& boxes);
+
+  void attach();
+
+  void detach();
+
+  void buildTree();
+
+  void buildGrid();
+
+  void markDirty(size_t index);
+
+  void forget(size_t index);
+
+  void flush();
+
+  void refit(size_t node);
+
+  size_t column(double x) const;
+
+  size_t row(double y) const;
+
+  void place(size_t index, bool insert);
+
+  template <typename Visitor>
+  void visit(const BoundingBox& box, Visitor visitor);
+
+  Shape* nearestInTree(Point point);
+
+  Shape* nearestInGrid(Point point);
+
+  friend class Shape;
+};
+
+Shape::~Shape() {
+  for (const auto& entry : slots_.entries) {
+    entry.first->forget(entry.second);
+  }
+}
+
+void Shape::touch() {
+  for (const auto& entry : slots_.entries) {
+    entry.first->markDirty(entry.second);
+  }
+}
+
+ShapeIndex::ShapeIndex(const std::vector<Shape*>& shapes, Layout layout)
+        : layout_(layout) {
+  entries_.reserve(shapes.size());
+  for (Shape* shape : shapes) {
+    entries_.push_back({shape, shape->boundingBox(), kNone, false});
+  }
+  rebuild();
+}
+
+ShapeIndex::~ShapeIndex() { detach(); }
+
+void ShapeIndex::rebuild() {
+  detach();
+  entries_.erase(std::remove_if(entries_.begin(), entries_.end(),
+                                [](const Entry& entry) {
+                                  return entry.shape == nullptr;
+                                }),
+                 entries_.end());
+  for (auto& entry : entries_) {
+    entry.box = entry.shape->boundingBox();
+    entry.dirty = false;
+  }
+  dirty_.clear();
+  moved_ = 0;
+  nodes_.clear();
+  if (layout_ == Layout::kRTree) {
+    buildTree();
+  } else {
+    buildGrid();
+  }
+  attach();
+}
+
+void ShapeIndex::attach() {
+  for (size_t index = 0; index < entries_.size(); ++index) {
+    entries_[index].shape->slots_.entries.emplace_back(this, index);
+  }
+}
+
+void ShapeIndex::detach() {
+  auto owned = [this](const std::pair<ShapeIndex*, size_t>& slot) {
+    return slot.first == this;
+  };
+  for (const auto& entry : entries_) {
+    if (entry.shape != nullptr) {
+      auto& slots = entry.shape->slots_.entries;
+      slots.erase(std::remove_if(slots.begin(), slots.end(), owned),
+                  slots.end());
+    }
+  }
+}
+
+std::vector<size_t> ShapeIndex::PackOrder(
+        const std::vector<BoundingBox>& boxes) {
+  std::vector<size_t> order(boxes.size());
+  std::iota(order.begin(), order.end(), 0);
+  size_t leaves = (boxes.size() + kNodeCapacity - 1) / kNodeCapacity;
+  size_t slices = static_cast<size_t>(ceil(sqrt(static_cast<double>(leaves))));
+  size_t slice = std::max<size_t>(slices, 1) * kNodeCapacity;
+  std::sort(order.begin(), order.end(), [&boxes](size_t left, size_t right) {
+    return boxes[left].center().x < boxes[right].center().x;
+  });
+  for (size_t begin = 0; begin < order.size(); begin += slice) {
+    auto end = order.begin() + std::min(begin + slice, order.size());
+    std::sort(order.begin() + begin, end, [&boxes](size_t left, size_t right) {
+      return boxes[left].center().y < boxes[right].center().y;
+    });
+  }
+  return order;
+}
+
+void ShapeIndex::buildTree() {
+  if (entries_.empty()) {
+    return;
+  }
+  std::vector<BoundingBox> boxes;
+  for (const auto& entry : entries_) {
+    boxes.push_back(entry.box);
+  }
+  std::vector<Entry> sorted;
+  for (size_t index : PackOrder(boxes)) {
+    sorted.push_back(entries_[index]);
+  }
+  entries_ = std::move(sorted);
+  for (size_t first = 0; first < entries_.size(); first += kNodeCapacity) {
+    size_t count = std::min(kNodeCapacity, entries_.size() - first);
+    nodes_.push_back({entries_[first].box, first, count, kNone, true});
+    refit(nodes_.size() - 1);
+  }
+  size_t begin = 0;
+  size_t end = nodes_.size();
+  while (end - begin > 1) {
+    boxes.clear();
+    for (size_t i = begin; i < end; ++i) {
+      boxes.push_back(nodes_[i].box);
+    }
+    std::vector<Node> level;
+    for (size_t index : PackOrder(boxes)) {
+      level.push_back(nodes_[begin + index]);
+    }
+    std::copy(level.begin(), level.end(), nodes_.begin() + begin);
+    for (size_t first = begin; first < end; first += kNodeCapacity) {
+      size_t count = std::min(kNodeCapacity, end - first);
+      nodes_.push_back({nodes_[first].box, first, count, kNone, false});
+      refit(nodes_.size() - 1);
+    }
+    begin = end;
+    end = nodes_.size();
+  }
+  for (size_t node = 0; node < nodes_.size(); ++node) {
+    for (size_t i = 0; i < nodes_[node].count; ++i) {
+      size_t child = nodes_[node].first + i;
+      if (nodes_[node].leaf) {
+        entries_[child].leaf = node;
+      } else {
+        nodes_[child].parent = node;
+      }
+    }
+  }
+}
+
+void ShapeIndex::refit(size_t node) {
+  Node& current = nodes_[node];
+  current.box = current.leaf ? entries_[current.first].box
+                             : nodes_[current.first].box;
+  for (size_t i = 1; i < current.count; ++i) {
+    current.box.expand(current.leaf ? entries_[current.first + i].box
+                                    : nodes_[current.first + i].box);
+  }
+}
+
+void ShapeIndex::buildGrid() {
+  if (entries_.empty()) {
+    return;
+  }
+  bounds_ = entries_[0].box;
+  for (const auto& entry : entries_) {
+    bounds_.expand(entry.box);
+  }
+  double width = bounds_.max.x - bounds_.min.x;
+  double height = bounds_.max.y - bounds_.min.y;
+  columns_ = rows_ = static_cast<size_t>(
+          ceil(sqrt(static_cast<double>(entries_.size()))));
+  cell_width_ = width > 0 ? width / columns_ : 1;
+  cell_height_ = height > 0 ? height / rows_ : 1;
+  cells_.assign(columns_ * rows_, {});
+  seen_.assign(entries_.size(), 0);
+  for (size_t index = 0; index < entries_.size(); ++index) {
+    place(index, true);
+  }
+}
+
+size_t ShapeIndex::column(double x) const {
+  double cell = floor((x - bounds_.min.x) / cell_width_);
+  return static_cast<size_t>(
+          std::min(std::max(cell, 0.0), static_cast<double>(columns_ - 1)));
+}
+
+size_t ShapeIndex::row(double y) const {
+  double cell = floor((y - bounds_.min.y) / cell_height_);
+  return static_cast<size_t>(
+          std::min(std::max(cell, 0.0), static_cast<double>(rows_ - 1)));
+}
+
+void ShapeIndex::place(size_t index, bool insert) {
+  const BoundingBox& box = entries_[index].box;
+  for (size_t y = row(box.min.y); y <= row(box.max.y); ++y) {
+    for (size_t x = column(box.min.x); x <= column(box.max.x); ++x) {
+      std::vector<size_t>& cell = cells_[y * columns_ + x];
+      if (insert) {
+        cell.push_back(index);
+      } else {
+        *std::find(cell.begin(), cell.end(), index) = cell.back();
+        cell.pop_back();
+      }
+    }
+  }
+}
+
+void ShapeIndex::markDirty(size_t index) {
+  std::lock_guard<std::mutex> lock(dirty_mutex_);
+  if (!entries_[index].dirty) {
+    entries_[index].dirty = true;
+    dirty_.push_back(index);
+  }
+}
+
+void ShapeIndex::forget(size_t index) {
+  Entry& entry = entries_[index];
+  if (layout_ == Layout::kGrid) {
+    place(index, false);
+  }
+  entry.shape = nullptr;
+  entry.box = BoundingBox(
+          Point(std::numeric_limits<double>::infinity(),
+                std::numeric_limits<double>::infinity()),
+          Point(-std::numeric_limits<double>::infinity(),
+                -std::numeric_limits<double>::infinity()));
+}
+
+void ShapeIndex::flush() {
+  std::lock_guard<std::mutex> lock(dirty_mutex_);
+  if (dirty_.empty()) {
+    return;
+  }
+  for (size_t index : dirty_) {
+    Entry& entry = entries_[index];
+    entry.dirty = false;
+    if (entry.shape == nullptr) {
+      continue;
+    }
+    if (layout_ == Layout::kRTree) {
+      entry.box = entry.shape->boundingBox();
+      for (size_t node = entry.leaf; node != kNone;
+           node = nodes_[node].parent) {
+        refit(node);
+      }
+    } else {
+      place(index, false);
+      entry.box = entry.shape->boundingBox();
+      place(index, true);
+    }
+  }
+  moved_ += dirty_.size();
+  dirty_.clear();
+  if (moved_ > entries_.size()) {
+    rebuild();
+  }
+}
+
+template <typename Visitor>
+void ShapeIndex::visit(const BoundingBox& box, Visitor visitor) {
+  flush();
+  if (entries_.empty()) {
+    return;
+  }
+  if (layout_ == Layout::kGrid) {
+    ++stamp_;
+    for (size_t y = row(box.min.y); y <= row(box.max.y); ++y) {
+      for (size_t x = column(box.min.x); x <= column(box.max.x); ++x) {
+        for (size_t index : cells_[y * columns_ + x]) {
+          if (seen_[index] != stamp_ && entries_[index].box.intersects(box)) {
+            seen_[index] = stamp_;
+            visitor(entries_[index]);
+          }
+        }
+      }
+    }
+    return;
+  }
+  std::vector<size_t> stack(1, nodes_.size() - 1);
+  while (!stack.empty()) {
+    const Node& node = nodes_[stack.back()];
+    stack.pop_back();
+    if (!node.box.intersects(box)) {
+      continue;
+    }
+    for (size_t i = node.first; i < node.first + node.count; ++i) {
+      if (!node.leaf) {
+        stack.push_back(i);
+      } else if (entries_[i].box.intersects(box)) {
+        visitor(entries_[i]);
+      }
+    }
+  }
+}
+
+std::vector<Shape*> ShapeIndex::containing(Point point) {
+  std::vector<Shape*> shapes;
+  visit(BoundingBox(point, point), [&shapes, point](const Entry& entry) {
+    if (entry.shape->containsPoint(point)) {
+      shapes.push_back(entry.shape);
+    }
+  });
+  return shapes;
+}
+
+std::vector<Shape*> ShapeIndex::intersecting(const BoundingBox& box) {
+  std::vector<Shape*> shapes;
+  visit(box, [&shapes](const Entry& entry) { shapes.push_back(entry.shape); });
+  return shapes;
+}
+
+Shape* ShapeIndex::nearest(Point point) {
+  flush();
+  if (entries_.empty()) {
+    return nullptr;
+  }
+  return layout_ == Layout::kRTree ? nearestInTree(point)
+                                   : nearestInGrid(point);
+}
+
+Shape* ShapeIndex::nearestInTree(Point point) {
+  using Candidate = std::pair<double, size_t>;
+  std::priority_queue<Candidate, std::vector<Candidate>,
+                      std::greater<Candidate>>
+          queue;
+  queue.emplace(nodes_.back().box.distance(point), nodes_.size() - 1);
+  Shape* best = nullptr;
+  double best_distance = std::numeric_limits<double>::infinity();
+  while (!queue.empty() && queue.top().first < best_distance) {
+    const Node& node = nodes_[queue.top().second];
+    queue.pop();
+    for (size_t i = node.first; i < node.first + node.count; ++i) {
+      if (!node.leaf) {
+        queue.emplace(nodes_[i].box.distance(point), i);
+      } else if (entries_[i].box.distance(point) < best_distance) {
+        best_distance = entries_[i].box.distance(point);
+        best = entries_[i].shape;
+      }
+    }
+  }
+  return best;
+}
+
+Shape* ShapeIndex::nearestInGrid(Point point) {
+  size_t center_x = column(point.x);
+  size_t center_y = row(point.y);
+  Shape* best = nullptr;
+  double best_distance = std::numeric_limits<double>::infinity();
+  auto scan = [&](size_t x, size_t y) {
+    if (x >= columns_ || y >= rows_) {
+      return;
+    }
+    for (size_t index : cells_[y * columns_ + x]) {
+      double distance = entries_[index].box.distance(point);
+      if (distance < best_distance) {
+        best_distance = distance;
+        best = entries_[index].shape;
+      }
+    }
+  };
+  size_t rings = std::max(columns_, rows_);
+  for (size_t ring = 0; ring < rings; ++ring) {
+    size_t low_x = center_x >= ring ? center_x - ring : 0;
+    size_t low_y = center_y >= ring ? center_y - ring : 0;
+    for (size_t x = low_x; x <= center_x + ring && x < columns_; ++x) {
+      if (center_y >= ring) {
+        scan(x, center_y - ring);
+      }
+      if (ring != 0) {
+        scan(x, center_y + ring);
+      }
+    }
+    for (size_t y = low_y; y <= center_y + ring && y < rows_; ++y) {
+      if (y + ring == center_y || y == center_y + ring) {
+        continue;
+      }
+      if (center_x >= ring) {
+        scan(center_x - ring, y);
+      }
+      scan(center_x + ring, y);
+    }
+    if (best_distance <= ring * std::min(cell_width_, cell_height_)) {
+      break;
+    }
+  }
+  return best;
+}
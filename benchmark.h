@@ -0,0 +1,233 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <new>
+#include <stdexcept>
+#include <string>
+#include <utility>
+#include <vector>
+
+// Shared by the per-task benchmark.cpp files. Each of them is a single
+// translation unit, so the counting operators new below are defined once.
+
+std::atomic<size_t> allocations{0};
+
+[[gnu::noinline]] void* operator new(size_t size) {
+  allocations.fetch_add(1, std::memory_order_relaxed);
+  if (void* ptr = std::malloc(size == 0 ? 1 : size)) {
+    return ptr;
+  }
+  throw std::bad_alloc();
+}
+
+[[gnu::noinline]] void operator delete(void* ptr) noexcept { std::free(ptr); }
+
+[[gnu::noinline]] void operator delete(void* ptr, size_t /*size*/) noexcept {
+  std::free(ptr);
+}
+
+[[gnu::noinline]] void* operator new(size_t size, std::align_val_t align) {
+  allocations.fetch_add(1, std::memory_order_relaxed);
+  size_t alignment = std::max(static_cast<size_t>(align), sizeof(void*));
+  size_t rounded = (std::max<size_t>(size, 1) + alignment - 1) /
+                   alignment * alignment;
+  if (void* ptr = std::aligned_alloc(alignment, rounded)) {
+    return ptr;
+  }
+  throw std::bad_alloc();
+}
+
+[[gnu::noinline]] void operator delete(void* ptr,
+                                       std::align_val_t /*align*/) noexcept {
+  std::free(ptr);
+}
+
+[[gnu::noinline]] void operator delete(void* ptr, size_t /*size*/,
+                                       std::align_val_t /*align*/) noexcept {
+  std::free(ptr);
+}
+
+struct Options {
+  std::string filter;
+  size_t repetitions = 5;
+  size_t threads = 1;
+  double min_time = 0.05;
+  std::vector<std::pair<std::string, size_t>> limits;
+
+  size_t limit(const std::string& name) const;
+};
+
+size_t Options::limit(const std::string& name) const {
+  for (const auto& limit : limits) {
+    if (limit.first == name) {
+      return limit.second;
+    }
+  }
+  throw std::out_of_range("Unknown benchmark limit " + name);
+}
+
+class BenchmarkSuite {
+ public:
+  explicit BenchmarkSuite(const Options& options) : options_(options) {}
+
+  bool selected(const std::string& name) const {
+    return name.find(options_.filter) != std::string::npos;
+  }
+
+  size_t limit(const std::string& name) const { return options_.limit(name); }
+
+  void describe(const std::string& key, const std::string& json) {
+    fields_.emplace_back(key, json);
+  }
+
+  // bytes is the input consumed per iteration; when non-zero the result
+  // also reports throughput.
+  template <typename Body>
+  void run(const std::string& name, size_t size, Body body, size_t bytes = 0);
+
+  void print(std::ostream& ostream) const;
+
+ private:
+  struct Result {
+    std::string name;
+    size_t size;
+    size_t iterations;
+    size_t repetitions;
+    double median_ns;
+    double min_ns;
+    double allocations;
+    size_t bytes;
+  };
+
+  static constexpr double kSlowLimit = 1.0;
+  static const size_t kMaxIterations = 1 << 24;
+  Options options_;
+  std::vector<std::pair<std::string, std::string>> fields_;
+  std::vector<Result> results_;
+  volatile double sink_ = 0;
+
+  template <typename Body>
+  double measure(Body& body, size_t iterations);
+};
+
+template <typename Body>
+double BenchmarkSuite::measure(Body& body, size_t iterations) {
+  auto start = std::chrono::steady_clock::now();
+  double sink = 0;
+  for (size_t i = 0; i < iterations; ++i) {
+    sink += static_cast<double>(body());
+  }
+  sink_ = sink_ + sink;
+  return std::chrono::duration<double>(std::chrono::steady_clock::now() -
+                                       start)
+          .count();
+}
+
+template <typename Body>
+void BenchmarkSuite::run(const std::string& name, size_t size, Body body,
+                         size_t bytes) {
+  std::vector<double> samples;
+  samples.reserve(options_.repetitions);
+  size_t iterations = 1;
+  size_t allocated = allocations.load();
+  double elapsed = measure(body, iterations);
+  while (elapsed < options_.min_time && iterations < kMaxIterations) {
+    size_t scale = elapsed > 0 ? static_cast<size_t>(options_.min_time /
+                                                     elapsed * 1.2) + 1
+                               : 16;
+    iterations = std::min(kMaxIterations, iterations * std::min<size_t>(
+                                                  std::max<size_t>(scale, 2),
+                                                  16));
+    allocated = allocations.load();
+    elapsed = measure(body, iterations);
+  }
+  size_t repetitions = elapsed > kSlowLimit ? 1 : options_.repetitions;
+  samples.push_back(elapsed / iterations);
+  while (samples.size() < repetitions) {
+    samples.push_back(measure(body, iterations) / iterations);
+  }
+  allocated = allocations.load() - allocated;
+  std::sort(samples.begin(), samples.end());
+  results_.push_back({name, size, iterations, samples.size(),
+                      samples[samples.size() / 2] * 1e9, samples[0] * 1e9,
+                      static_cast<double>(allocated) /
+                              static_cast<double>(samples.size() *
+                                                  iterations),
+                      bytes});
+  std::cerr << name << "/" << size << ": " << results_.back().median_ns
+            << " ns\n";
+}
+
+void BenchmarkSuite::print(std::ostream& ostream) const {
+  ostream << std::fixed << std::setprecision(1);
+  ostream << "{\n";
+  for (const auto& field : fields_) {
+    ostream << "  \"" << field.first << "\": " << field.second << ",\n";
+  }
+  ostream << "  \"benchmarks\": [";
+  for (size_t i = 0; i < results_.size(); ++i) {
+    const Result& result = results_[i];
+    ostream << (i == 0 ? "\n" : ",\n");
+    ostream << "    {\"name\": \"" << result.name
+            << "\", \"size\": " << result.size
+            << ", \"iterations\": " << result.iterations
+            << ", \"repetitions\": " << result.repetitions
+            << ", \"median_ns\": " << result.median_ns
+            << ", \"min_ns\": " << result.min_ns
+            << ", \"allocations\": " << result.allocations;
+    if (result.bytes != 0) {
+      ostream << ", \"bytes\": " << result.bytes
+              << ", \"bytes_per_second\": "
+              << static_cast<double>(result.bytes) / result.median_ns * 1e9;
+    }
+    ostream << "}";
+  }
+  ostream << "\n  ]\n}\n";
+}
+
+std::vector<size_t> Sizes(size_t first, size_t max_size) {
+  std::vector<size_t> sizes;
+  for (size_t size = first; size <= max_size; size *= 10) {
+    sizes.push_back(size);
+  }
+  return sizes;
+}
+
+Options ParseOptions(int argc, char** argv,
+                     std::vector<std::pair<std::string, size_t>> limits) {
+  Options options;
+  options.limits = std::move(limits);
+  std::string usage = "Usage: benchmark [--filter=NAME]";
+  for (const auto& limit : options.limits) {
+    usage += " [--" + limit.first + "=N]";
+  }
+  usage += " [--repetitions=N] [--threads=N] [--min-time=SECONDS]";
+  for (int i = 1; i < argc; ++i) {
+    std::string arg = argv[i];
+    std::string value = arg.substr(arg.find('=') + 1);
+    auto limit = std::find_if(
+            options.limits.begin(), options.limits.end(),
+            [&arg](const std::pair<std::string, size_t>& limit) {
+              return arg.rfind("--" + limit.first + "=", 0) == 0;
+            });
+    if (arg.rfind("--filter=", 0) == 0) {
+      options.filter = value;
+    } else if (limit != options.limits.end()) {
+      limit->second = std::stoull(value);
+    } else if (arg.rfind("--repetitions=", 0) == 0) {
+      options.repetitions = std::max<size_t>(1, std::stoull(value));
+    } else if (arg.rfind("--threads=", 0) == 0) {
+      options.threads = std::max<size_t>(1, std::stoull(value));
+    } else if (arg.rfind("--min-time=", 0) == 0) {
+      options.min_time = std::stod(value);
+    } else {
+      throw std::invalid_argument(usage);
+    }
+  }
+  return options;
+}